@@ -201,7 +201,7 @@ static void enc28j60_int(void *data)
 
   stm32_exti_irq_ack(d->exti);
 
-  sem_post(eth_wakeup);
+  event_set(eth_wakeup, ETH_EVENT_RX);
 }
 
 /*  ERXRDPTL must never be set to an even value - erratum 14 */
@@ -35,7 +35,7 @@
 #define BYTE(v, n) (((unsigned int)(v) >> (n << 3)) & 0xff)
 
 struct netif ethif;
-bmos_sem_t *eth_wakeup;
+bmos_event_t *eth_wakeup;
 static signed char has_addr;
 
 #if 0
@@ -60,7 +60,7 @@ void task_net()
   lwip_init();
   lwip_test_init();
 
-  eth_wakeup = sem_create("eth_wakeup", 0);
+  eth_wakeup = event_create("eth_wakeup");
 
   netif_add(&ethif, &ipaddr, &netmask, &gateway, NULL, \
             &eth_init, &ethernet_input);
@@ -71,12 +71,20 @@ void task_net()
   dhcp_start(&ethif);
 
   for (;;) {
-    int err;
-    err = sem_wait_ms(eth_wakeup, 1000);
-    eth_input(&ethif);
+    unsigned int ev;
+    u32_t tms;
 
-    if (err < 0)
-      sys_check_timeouts();
+    /* sleep until a frame arrives or is sent, or the next lwip timeout is
+       due */
+    tms = sys_timeouts_sleeptime();
+
+    ev = event_wait_ms(eth_wakeup, ETH_EVENT_RX | ETH_EVENT_TX,
+                       EVENT_WAIT_ANY | EVENT_CLEAR,
+                       tms == SYS_TIMEOUTS_SLEEPTIME_INFINITE ? -1 : (int)tms);
+    if (ev & (ETH_EVENT_RX | ETH_EVENT_TX))
+      eth_input(&ethif);
+
+    sys_check_timeouts();
 
     if (!has_addr && dhcp_supplied_address(&ethif)) {
       xslog(LOG_INFO, "ip:%d.%d.%d.%d"
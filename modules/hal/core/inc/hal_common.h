@@ -110,6 +110,10 @@ int bl_enter(void);
 
 void hal_init();
 
+/* make any further heap growth through sbrk fatal */
+void sbrk_lock(void);
+int sbrk_is_locked(void);
+
 unsigned int hal_flash_size(void);
 
 #endif
@@ -52,5 +52,7 @@ void dma_start(unsigned int num, unsigned int chan);
 #define DMA_IRQ_STATUS_FULL BIT(0)
 #define DMA_IRQ_STATUS_HALF BIT(1)
 unsigned int dma_irq_ack(unsigned int num, unsigned int chan);
+/* items left before the channel wraps or completes */
+unsigned int dma_get_count(unsigned int num, unsigned int chan);
 
 #endif
@@ -31,6 +31,7 @@ typedef void dma_set_chan_t(void *data, unsigned int chan, unsigned int devid);
 typedef void dma_en_t(void *data, unsigned int chan, int en);
 typedef void dma_start_t(void *data, unsigned int chan);
 typedef unsigned int dma_irq_ack_t(void *data, unsigned int chan);
+typedef unsigned int dma_get_count_t(void *data, unsigned int chan);
 
 typedef struct {
   dma_trans_t *trans;
@@ -38,6 +39,7 @@ typedef struct {
   dma_en_t *en;
   dma_start_t *start;
   dma_irq_ack_t *irq_ack;
+  dma_get_count_t *get_count;
 } dma_controller_t;
 
 typedef struct {
@@ -29,6 +29,10 @@
 
 #include "circ_buf.h"
 
+#ifndef CONFIG_UART_TX_BATCH
+#define CONFIG_UART_TX_BATCH 4
+#endif
+
 typedef struct {
   const char *name;
   unsigned long base;
@@ -39,6 +43,14 @@ typedef struct {
   const char *tx_queue_name;
   unsigned char msg_pow2;
   unsigned char msg_cnt;
+  /* dma channels, used with STM32_UART_DMA_RX/TX */
+  unsigned char dma_num;
+  unsigned char rx_dma_chan;
+  unsigned char rx_dma_devid;
+  unsigned char rx_dma_irq;
+  unsigned char tx_dma_chan;
+  unsigned char tx_dma_devid;
+  unsigned char tx_dma_irq;
   /* initialized by driver */
   unsigned char msg_len;
   unsigned char pad0;
@@ -51,9 +63,13 @@ typedef struct {
   bmos_queue_t *rxq;
   bmos_queue_t *pool;
   bmos_op_msg_t *msg;
+  bmos_op_msg_t *rx_msg; /* the dma rx target */
   unsigned char *data;
   unsigned short data_len;
   unsigned short op;
+  bmos_op_msg_t *tx_batch[CONFIG_UART_TX_BATCH];
+  unsigned char tx_cnt;
+  unsigned char tx_pos;
 #endif
   circ_buf_t cb;
 } uart_t;
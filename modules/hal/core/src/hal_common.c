@@ -38,6 +38,7 @@ extern unsigned int _isr_start, _isr_end;
 #endif
 
 static unsigned int sbrk_next = (unsigned int)&_end;
+static unsigned char sbrk_locked;
 
 void _data_init(void)
 {
@@ -149,6 +150,9 @@ void *_sbrk(int count)
 
   XASSERT(count >= 0);
 
+  if (count > 0 && sbrk_locked)
+    xpanic("sbrk %d after lock", count);
+
   if (count > 0)
     /* align to next 8 byte boundary */
     sbrk_next += ALIGN(count, 3);
@@ -159,6 +163,16 @@ void *_sbrk(int count)
   return (void *)cur;
 }
 
+void sbrk_lock(void)
+{
+  sbrk_locked = 1;
+}
+
+int sbrk_is_locked(void)
+{
+  return sbrk_locked;
+}
+
 void hal_init(void)
 {
 #if ARCH_STM32
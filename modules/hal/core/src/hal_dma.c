@@ -68,6 +68,12 @@ unsigned int dma_irq_ack(unsigned int num, unsigned int chan)
   return cont->irq_ack(cont_data->data, chan);
 }
 
+unsigned int dma_get_count(unsigned int num, unsigned int chan)
+{
+  GET_CONT_DATA;
+  return cont->get_count(cont_data->data, chan);
+}
+
 #if 0
 int dma_controller_reg(unsigned int num, dma_controller_t *cont, void *data)
 {
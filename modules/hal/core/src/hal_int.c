@@ -22,11 +22,32 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "fast_log.h"
 #include "hal_int.h"
 #include "io.h"
 #include "shell.h"
 #include "xassert.h"
 
+#ifndef CONFIG_IRQ_STATS
+#define CONFIG_IRQ_STATS 0
+#endif
+
+#if CONFIG_IRQ_STATS
+/* armv6-m has no cycle counter, fall back to the microsecond timer */
+#if __ARM_ARCH_6M__
+#include "hal_time.h"
+#define IRQ_NOW() hal_time_us()
+#define IRQ_UNIT "us"
+#define IRQ_HIST_SHIFT 0
+#else
+#include "cortexm.h"
+#define IRQ_NOW() cycle_cnt()
+#define IRQ_UNIT "cycles"
+#define IRQ_HIST_SHIFT 5
+#endif
+#define IRQ_N_HIST 8
+#endif
+
 #if 0
 int cmd_irqe(int argc, char *argv[])
 {
@@ -62,6 +83,12 @@ typedef struct irq_handler_data {
   void *data;
   const char *name;
   unsigned int count;
+#if CONFIG_IRQ_STATS
+  unsigned int min;
+  unsigned int max;
+  unsigned long long total;
+  unsigned int hist[IRQ_N_HIST];
+#endif
 } irq_handler_data_t;
 
 #ifdef CONFIG_N_INTS
@@ -87,8 +114,33 @@ void irq_stats_reset(unsigned int num)
 
   c = &interrupts[num];
   c->count = 0;
+#if CONFIG_IRQ_STATS
+  c->min = ~0U;
+  c->max = 0;
+  c->total = 0;
+  memset(c->hist, 0, sizeof(c->hist));
+#endif
 }
 
+#if CONFIG_IRQ_STATS
+static void irq_stats_add(irq_handler_data_t *c, unsigned int t)
+{
+  unsigned int v = t >> IRQ_HIST_SHIFT;
+  unsigned int b = 0;
+
+  if (t < c->min)
+    c->min = t;
+  if (t > c->max)
+    c->max = t;
+  c->total += t;
+
+  while ((v >>= 1) && b < IRQ_N_HIST - 1)
+    b++;
+
+  c->hist[b]++;
+}
+#endif
+
 void irq_register(const char *name, irq_handler_t *handler, void *data,
                   unsigned int num)
 {
@@ -102,6 +154,10 @@ void irq_register(const char *name, irq_handler_t *handler, void *data,
   c->name = name;
   irq_stats_reset(num);
 
+#if CONFIG_IRQ_STATS && !__ARM_ARCH_6M__
+  dwt_init();
+#endif
+
   /* clear any pending interrupts */
   irq_ack(num);
   irq_enable(num);
@@ -110,6 +166,9 @@ void irq_register(const char *name, irq_handler_t *handler, void *data,
 void irq_call(unsigned int num)
 {
   irq_handler_data_t *c;
+#if CONFIG_IRQ_STATS
+  unsigned int start;
+#endif
 
   XASSERT(num < N_INTS);
 
@@ -118,8 +177,16 @@ void irq_call(unsigned int num)
   if (c->handler == 0)
     xpanic("unhandled interrupt %d\n", num);
 
+  FAST_TRACE(FAST_TRACE_IRQ_B, num, c->name);
+#if CONFIG_IRQ_STATS
+  start = IRQ_NOW();
+#endif
   c->handler(c->data);
+#if CONFIG_IRQ_STATS
+  irq_stats_add(c, IRQ_NOW() - start);
+#endif
   c->count++;
+  FAST_TRACE(FAST_TRACE_IRQ_E, num, 0);
 }
 
 int cmd_irq(int argc, char *argv[])
@@ -127,14 +194,52 @@ int cmd_irq(int argc, char *argv[])
   irq_handler_data_t *c;
   unsigned int i;
 
+  if (argc > 1 && argv[1][0] == 'r') {
+    for (i = 0; i < N_INTS; i++)
+      if (interrupts[i].handler)
+        irq_stats_reset(i);
+    return 0;
+  }
+
+#if CONFIG_IRQ_STATS
+  xprintf("irq   count      min      avg      max name, " IRQ_UNIT
+          " histogram");
+  for (i = 0; i < IRQ_N_HIST - 1; i++)
+    xprintf(" <%u", 2U << (i + IRQ_HIST_SHIFT));
+  xprintf(" >=%u\n", 1U << (IRQ_N_HIST + IRQ_HIST_SHIFT - 1));
+#endif
+
   for (i = 0; i < N_INTS; i++) {
     c = &interrupts[i];
 
-    if (c->handler)
-      xprintf("%3d: %6d %s\n", i, c->count, c->name);
+    if (!c->handler)
+      continue;
+
+#if CONFIG_IRQ_STATS
+    if (c->count) {
+      unsigned int j;
+
+      xprintf("%3d: %6d %8u %8u %8u %s", i, c->count, c->min,
+              (unsigned int)(c->total / c->count), c->max, c->name);
+      for (j = 0; j < IRQ_N_HIST; j++)
+        xprintf(" %d", c->hist[j]);
+      xprintf("\n");
+      continue;
+    }
+#endif
+    xprintf("%3d: %6d %s\n", i, c->count, c->name);
   }
 
   return 0;
 }
 
-SHELL_CMD(irq, cmd_irq);
+#if CONFIG_SHELL_HELP
+static const char irq_help[] =
+  "show interrupt counts\n\n"
+#if CONFIG_IRQ_STATS
+  "each handler also gets min/avg/max run time and a log2 histogram\n"
+#endif
+  "irq r: reset counts";
+#endif
+
+SHELL_CMD_H(irq, cmd_irq, irq_help);
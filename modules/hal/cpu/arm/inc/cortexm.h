@@ -127,6 +127,7 @@ typedef struct {
 void set_low_power(int en);
 
 void systick_init();
+unsigned int systick_suppress(unsigned int n);
 
 static inline void trigger_pendsv()
 {
@@ -27,6 +27,7 @@
 
 #define __ISB() asm volatile ("isb")
 #define __DSB() asm volatile ("dsb")
+#define __DMB() asm volatile ("dmb" : : : "memory")
 
 #undef __WFI
 #define __WFI() asm volatile ("wfi")
@@ -51,6 +52,66 @@ static inline void set_faultmask(unsigned int msk)
   asm volatile ("msr faultmask, %0\n" : : "r" (msk));
 }
 
+/* interrupts at a priority above the ceiling (lower number) are never
+   masked by interrupt_disable() and must not call the os. 0 masks all
+   interrupts with primask */
+#ifndef CONFIG_IRQ_CEILING
+#define CONFIG_IRQ_CEILING 0
+#endif
+
+#if CONFIG_IRQ_CEILING
+#if __ARM_ARCH_6M__
+#error armv6-m has no basepri, CONFIG_IRQ_CEILING is not supported
+#endif
+
+/* same shift as irq_set_pri() */
+#define IRQ_CEILING_PRI (CONFIG_IRQ_CEILING << 4)
+
+#define NVIC_IPR ((volatile unsigned char *)0xe000e400)
+
+static inline unsigned int interrupt_disable()
+{
+  unsigned int ret;
+
+  asm volatile ("mrs %0, basepri\n"
+                "msr basepri_max, %1\n"
+                : "=&r" (ret) : "r" (IRQ_CEILING_PRI) : "memory");
+  return ret;
+}
+
+static inline void interrupt_enable(unsigned int saved)
+{
+  asm volatile ("msr basepri, %0\n"
+                : : "r" (saved) : "memory");
+}
+
+/* basepri also blocks wfi wakeup so drop to primask around it */
+static inline void interrupt_wfi()
+{
+  asm volatile ("cpsid i\n"
+                "msr basepri, %0\n"
+                "dsb\n"
+                "wfi\n"
+                "msr basepri, %1\n"
+                "cpsie i\n"
+                : : "r" (0), "r" (IRQ_CEILING_PRI) : "memory");
+}
+
+static inline int interrupt_above_ceiling()
+{
+  unsigned int ipsr;
+
+  asm volatile ("mrs %0, ipsr\n" : "=r" (ipsr));
+
+  /* system exceptions belong to the os */
+  if (ipsr < 16)
+    return 0;
+
+  return NVIC_IPR[ipsr - 16] < IRQ_CEILING_PRI;
+}
+
+#define INTERRUPT_ASSERT_CEILING() XASSERT(!interrupt_above_ceiling())
+#else
 static inline unsigned int interrupt_disable()
 {
   unsigned int ret;
@@ -67,4 +128,13 @@ static inline void interrupt_enable(unsigned int saved)
                 : : "r" (saved));
 }
 
+static inline void interrupt_wfi()
+{
+  __DSB();
+  __WFI();
+}
+
+#define INTERRUPT_ASSERT_CEILING() do { } while (0)
+#endif
+
 #endif
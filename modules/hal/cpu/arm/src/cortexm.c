@@ -100,8 +100,13 @@ void hal_cpu_init()
   /* set exception priorities */
   SCB->shpr[0] = 0x00000000;
   SCB->shpr[1] = 0x00000000;
+#if CONFIG_IRQ_CEILING
+  /* systick calls the os so it has to sit at the ceiling */
+  SCB->shpr[2] = 0x00ff0000 | (IRQ_CEILING_PRI << 24);
+#else
   /* systick has highest priority, pendsv has lowest priority */
   SCB->shpr[2] = 0x00ff0000;
+#endif
 #endif
 
   for (i = 0; i < 8; i++)
@@ -122,6 +127,9 @@ void hal_cpu_fini()
 #define SYSTICK_CTRL_TICKINT BIT(1)
 /* Clock source 0 - AHB / 8, 1 - AHB */
 #define SYSTICK_CTRL_CLKSOURCE BIT(2)
+#define SYSTICK_CTRL_COUNTFLAG BIT(16)
+
+#define SYSTICK_MAX_LOAD 0xffffff
 
 #ifndef HAL_CPU_CLOCK
 #define HAL_CPU_CLOCK hal_cpu_clock
@@ -136,6 +144,67 @@ void systick_init()
                   SYSTICK_CTRL_ENABLE;
 }
 
+/* Stretch the current tick period so the next systick interrupt happens
+   up to n ticks from the last one and wait for an interrupt. Must be called
+   with interrupts disabled. Returns the number of tick boundaries that
+   passed while sleeping, not counting the tick of a pending systick
+   interrupt, so the caller can correct the tick count.
+ */
+unsigned int systick_suppress(unsigned int n)
+{
+  unsigned int per = HAL_CPU_CLOCK / 1000;
+  unsigned int max = SYSTICK_MAX_LOAD / per;
+  unsigned int load, val, ctrl, done, elapsed;
+
+  if (n > max)
+    n = max;
+
+  if (n < 2) {
+    interrupt_wfi();
+    return 0;
+  }
+
+  /* stop the counter keeping what is left of the current period */
+  SYSTICK->ctrl &= ~SYSTICK_CTRL_ENABLE;
+  val = SYSTICK->val;
+  load = val + (n - 1) * per;
+
+  SYSTICK->load = load;
+  SYSTICK->val = 0;
+  SYSTICK->ctrl |= SYSTICK_CTRL_ENABLE;
+
+  interrupt_wfi();
+  __ISB();
+
+  /* reading ctrl clears the count flag */
+  ctrl = SYSTICK->ctrl;
+  SYSTICK->ctrl = ctrl & ~SYSTICK_CTRL_ENABLE;
+
+  if (ctrl & SYSTICK_CTRL_COUNTFLAG) {
+    /* full period elapsed - the pending interrupt counts the last tick */
+    elapsed = n - 1;
+    SYSTICK->load = per - 1;
+  } else {
+    /* woken early by another interrupt, keep the tick phase */
+    done = load - SYSTICK->val;
+    if (done < val) {
+      elapsed = 0;
+      SYSTICK->load = val - done;
+    } else {
+      done -= val;
+      elapsed = 1 + done / per;
+      SYSTICK->load = per - done % per;
+    }
+  }
+
+  SYSTICK->val = 0;
+  SYSTICK->ctrl |= SYSTICK_CTRL_ENABLE;
+  /* takes effect at the next reload */
+  SYSTICK->load = per - 1;
+
+  return elapsed;
+}
+
 void exception_handler(void) __attribute__((naked));
 
 #ifndef CONFIG_SIMPLE_EXCEPTION_HANDLER
@@ -257,8 +326,14 @@ void exception_handler()
 void interrupt_handler()
 {
   unsigned int e;
+#if CONFIG_IRQ_CEILING
+  unsigned int saved;
 
+  /* only mask up to the ceiling so higher interrupts can nest */
+  saved = interrupt_disable();
+#else
   INTERRUPT_OFF();
+#endif
 
   e = (SCB->icsr & 0xff) - 16;
 
@@ -268,7 +343,11 @@ void interrupt_handler()
 
   FAST_LOG('I', "irqE %d\n", e, 0);
 
+#if CONFIG_IRQ_CEILING
+  interrupt_enable(saved);
+#else
   INTERRUPT_ON();
+#endif
 }
 
 void irq_enable(unsigned int n)
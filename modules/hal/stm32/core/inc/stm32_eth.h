@@ -35,12 +35,16 @@ void hal_eth_config_get(hal_eth_config_t *config);
 
 #if CONFIG_LWIP
 #include "lwip/netif.h"
-#include "bmos_sem.h"
+#include "bmos_event.h"
 
 extern void eth_input(struct netif *nif);
 extern err_t eth_init(struct netif *nif);
 
-extern bmos_sem_t *eth_wakeup;
+/* eth_wakeup event bits */
+#define ETH_EVENT_RX 0x1
+#define ETH_EVENT_TX 0x2
+
+extern bmos_event_t *eth_wakeup;
 #endif
 
 #endif
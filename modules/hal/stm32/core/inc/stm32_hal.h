@@ -39,6 +39,8 @@ void led_set(unsigned int n, unsigned int v);
 #define STM32_UART_LP BIT(0)
 #define STM32_UART_FIFO BIT(1)
 #define STM32_UART_SINGLE_WIRE BIT(2)
+#define STM32_UART_DMA_RX BIT(3)
+#define STM32_UART_DMA_TX BIT(4)
 
 void led_init(const gpio_handle_t *led_list, unsigned int _nleds);
 
@@ -19,6 +19,7 @@
  * IN THE SOFTWARE.
  */
 
+#include <stdlib.h>
 #include <string.h>
 
 #include "common.h"
@@ -36,6 +37,23 @@
 #include "stm32_eth.h"
 #endif
 
+/* hand received frames to lwip in place instead of copying them into
+   PBUF_POOL pbufs */
+#ifndef CONFIG_ETH_RX_ZERO_COPY
+#define CONFIG_ETH_RX_ZERO_COPY 1
+#endif
+
+#if CONFIG_LWIP && CONFIG_ETH_RX_ZERO_COPY
+#define ETH_RX_ZERO_COPY 1
+#include <stddef.h>
+
+#include "xassert.h"
+#include "bmos_mempool.h"
+#include "lwip/pbuf.h"
+#else
+#define ETH_RX_ZERO_COPY 0
+#endif
+
 #define ETH_BASE 0x40028000
 
 typedef struct {
@@ -153,9 +171,12 @@ typedef struct {
     ETH_DMAIER_TUIE | ETH_DMAIER_ROIE | ETH_DMAIER_TJTIE | \
     ETH_DMAIER_TBUIE | ETH_DMAIER_TPSIE | ETH_DMAIER_TIE)
 
+#define ETH_DMA_OMR_TSF BIT(21)
 #define ETH_DMA_OMR_ST BIT(13)
 #define ETH_DMA_OMR_SR BIT(1)
 
+#define ETH_MACCR_IPCO BIT(10)
+
 #define FIELD(w, o, v) (((v) & ((1 << (w)) - 1)) << (o))
 
 #define ETH_TDES0_OWN BIT(31)
@@ -211,81 +232,220 @@ typedef struct {
 #define ETH_DMASR_AIS BIT(15)
 #define ETH_DMASR_NIS BIT(16)
 
-#define N_RX_DES 4
-#define N_TX_DES 4
+/* descriptor ring sizes, boards with the memory can go deeper */
+#ifndef CONFIG_ETH_RX_DES
+#define CONFIG_ETH_RX_DES 4
+#endif
+
+#ifndef CONFIG_ETH_TX_DES
+#define CONFIG_ETH_TX_DES 4
+#endif
+
+/* rx interrupt coalescing: interrupt every CONFIG_ETH_RX_COAL frames and
+   let the rx watchdog (units of 256 bus clocks) pick up the rest, a
+   watchdog of 0 interrupts on every frame */
+#ifndef CONFIG_ETH_RX_COAL
+#define CONFIG_ETH_RX_COAL 1
+#endif
+
+#ifndef CONFIG_ETH_RX_WDT
+#define CONFIG_ETH_RX_WDT 0
+#endif
+
+/* have the mac insert and verify ip/udp/tcp/icmp checksums, "eth k"
+   switches it at run time */
+#ifndef CONFIG_ETH_CSUM_OFFLOAD
+#define CONFIG_ETH_CSUM_OFFLOAD 1
+#endif
+
+/* frames received per eth_input() before lwip gets to run its timers */
+#ifndef CONFIG_ETH_RX_BUDGET
+#define CONFIG_ETH_RX_BUDGET 16
+#endif
+
+#define N_RX_DES CONFIG_ETH_RX_DES
+#define N_TX_DES CONFIG_ETH_TX_DES
 #define ETH_PKT_LEN 1524
 
 typedef struct {
   unsigned int des[4];
 } eth_des_t;
 
+#if ETH_RX_ZERO_COPY
+/* spare buffers for frames lwip is still holding */
+#ifndef CONFIG_ETH_RX_BUFS
+#define CONFIG_ETH_RX_BUFS (2 * N_RX_DES)
+#endif
+
+typedef struct {
+  unsigned char data[ETH_PKT_LEN];
+  struct pbuf_custom pc;
+} eth_rx_buf_t;
+
+static eth_rx_buf_t rx_bufs[CONFIG_ETH_RX_BUFS];
+static bmos_mempool_static_t rx_pool_static;
+static bmos_mempool_t *rx_pool;
+static eth_rx_buf_t *rx_buf[N_RX_DES];
+
+#define RX_DATA(idx) (rx_buf[idx]->data)
+#else
 static unsigned char rx_data[N_RX_DES][ETH_PKT_LEN];
+
+#define RX_DATA(idx) (rx_data[idx])
+#endif
 static eth_des_t rx_des[N_RX_DES];
 
+/* frames the dma cannot send in place are copied here */
 static unsigned char tx_data[N_TX_DES][ETH_PKT_LEN];
 static eth_des_t tx_des[N_TX_DES];
+/* chain held until the frame ending at this descriptor is sent */
+static struct pbuf *tx_pbuf[N_TX_DES];
 
 typedef struct {
   unsigned int currx;
   unsigned int curtx;
+  unsigned int txclean;
+  unsigned int rx_coal;
+  unsigned int rx_wdt;
+  unsigned int rx_cnt;
+  unsigned int tx_cnt;
+  unsigned int irq_cnt;
+  unsigned int rx_miss;
+  unsigned int rx_drop;
+  unsigned int tx_drop;
+  unsigned int tx_copy;
+  unsigned int rx_csum_err;
 } eth_ctx_t;
 
-void poll_rx_desc(eth_ctx_t *eth_ctx, struct netif *nif)
+static int eth_csum = CONFIG_ETH_CSUM_OFFLOAD;
+
+static void rx_des_arm(eth_ctx_t *eth_ctx, unsigned int idx)
 {
-  unsigned int idx = eth_ctx->currx;
-  eth_des_t *d;
-  int count = 0;
-  struct pbuf *p, *q;
-  unsigned int rem;
-  unsigned char *dat;
+  eth_des_t *d = &rx_des[idx];
+
+  d->des[1] = ETH_RDES1_RBS2(0) | ETH_RDES1_RBS1(ETH_PKT_LEN);
+  if (idx == N_RX_DES - 1)
+    d->des[1] |= ETH_RDES1_RER;
+  /* without an interrupt on completion the rx watchdog raises it */
+  if (eth_ctx->rx_wdt && (idx + 1) % eth_ctx->rx_coal)
+    d->des[1] |= ETH_RDES1_DIC;
+  d->des[2] = (unsigned int)RX_DATA(idx);
+  d->des[3] = 0;
+  d->des[0] = ETH_RDES0_OWN;
+}
 
-  d = &rx_des[idx];
+#if ETH_RX_ZERO_COPY
+/* lwip is done with the frame, the buffer goes back to the pool */
+static void rx_pbuf_free(struct pbuf *p)
+{
+  mempool_free(rx_pool, (char *)p - offsetof(eth_rx_buf_t, pc));
+}
 
-  while ((d->des[0] & ETH_RDES0_OWN) == 0) {
-    count++;
+static void rx_pool_init(void)
+{
+  unsigned int i;
 
-    rem = ETH_RDES0_FL(d->des[0]);
-    dat = rx_data[idx];
+  if (!rx_pool) {
+    rx_pool = mempool_init_static(&rx_pool_static, "ethrx",
+                                  CONFIG_ETH_RX_BUFS, sizeof(eth_rx_buf_t),
+                                  rx_bufs);
+    XASSERT(rx_pool);
+  }
 
-#if 0
-    xprintf("rx %d len: %d\n", idx, rem);
-#endif
+  for (i = 0; i < N_RX_DES; i++)
+    if (!rx_buf[i]) {
+      rx_buf[i] = mempool_alloc(rx_pool);
+      XASSERT(rx_buf[i]);
+    }
+}
 
-    p = pbuf_alloc(PBUF_RAW, rem, PBUF_POOL);
-    if (!p)
-      xslog(LOG_ERR, "could not allocate rx buffer %d\n", rem);
-    else {
-      err_t err;
+static void poll_rx_frame(eth_ctx_t *eth_ctx, struct netif *nif,
+                          unsigned int idx, unsigned int len)
+{
+  eth_rx_buf_t *b = rx_buf[idx], *nb;
+  struct pbuf *p;
+
+  /* when lwip holds every spare buffer the frame is dropped and its
+     buffer reused */
+  nb = mempool_alloc(rx_pool);
+  if (!nb) {
+    FAST_LOG('e', "eth rx drop\n", 0, 0);
+    eth_ctx->rx_drop++;
+    return;
+  }
 
-      for (q = p; q && (rem > 0); q = q->next) {
-        unsigned int cnt = q->len;
+  b->pc.custom_free_function = rx_pbuf_free;
+  p = pbuf_alloced_custom(PBUF_RAW, len, PBUF_REF, &b->pc, b->data,
+                          ETH_PKT_LEN);
 
-        if (rem < cnt)
-          cnt = rem;
+  rx_buf[idx] = nb;
 
-        memcpy(q->payload, dat, cnt);
+  if (nif->input(p, nif) != ERR_OK) {
+    xslog(LOG_ERR, "lwip input error\n");
+    pbuf_free(p);
+  }
+}
+#else
+static void poll_rx_frame(eth_ctx_t *eth_ctx, struct netif *nif,
+                          unsigned int idx, unsigned int rem)
+{
+  unsigned char *dat = rx_data[idx];
+  struct pbuf *p, *q;
 
-        dat += cnt;
-        rem -= cnt;
-      }
+  p = pbuf_alloc(PBUF_RAW, rem, PBUF_POOL);
+  if (!p) {
+    xslog(LOG_ERR, "could not allocate rx buffer %d\n", rem);
+    eth_ctx->rx_drop++;
+  } else {
+    err_t err;
 
-      err = nif->input(p, nif);
-      if (err != ERR_OK) {
-        xslog(LOG_ERR, "lwip input error\n");
-        pbuf_free(p);
-      }
+    for (q = p; q && (rem > 0); q = q->next) {
+      unsigned int cnt = q->len;
+
+      if (rem < cnt)
+        cnt = rem;
+
+      memcpy(q->payload, dat, cnt);
+
+      dat += cnt;
+      rem -= cnt;
     }
 
-    d->des[0] = ETH_RDES0_OWN;
-    d->des[1] = ETH_RDES1_RBS2(0) | ETH_RDES1_RBS1(ETH_PKT_LEN);
-    d->des[2] = (unsigned int)&rx_data[idx];
-    d->des[3] = 0;
+    err = nif->input(p, nif);
+    if (err != ERR_OK) {
+      xslog(LOG_ERR, "lwip input error\n");
+      pbuf_free(p);
+    }
+  }
+}
+#endif
+
+unsigned int poll_rx_desc(eth_ctx_t *eth_ctx, struct netif *nif,
+                          unsigned int budget)
+{
+  unsigned int idx = eth_ctx->currx, count = 0;
+  eth_des_t *d;
+
+  d = &rx_des[idx];
 
-    idx++;
-    if (idx >= N_RX_DES) {
-      d->des[1] |= ETH_RDES1_RER;
+  while ((d->des[0] & ETH_RDES0_OWN) == 0 && count < budget) {
+    count++;
+
+#if 0
+    xprintf("rx %d len: %d\n", idx, ETH_RDES0_FL(d->des[0]));
+#endif
+
+    /* lwip no longer checks, so frames the mac flagged go here */
+    if (eth_csum && (d->des[0] & ETH_RDES0_FT) &&
+        (d->des[0] & (ETH_RDES0_IPHCE | ETH_RDES0_PCE)))
+      eth_ctx->rx_csum_err++;
+    else
+      poll_rx_frame(eth_ctx, nif, idx, ETH_RDES0_FL(d->des[0]));
+
+    rx_des_arm(eth_ctx, idx);
+
+    if (++idx >= N_RX_DES)
       idx = 0;
-    }
     d = &rx_des[idx];
   }
 #if 0
@@ -293,15 +453,47 @@ void poll_rx_desc(eth_ctx_t *eth_ctx, struct netif *nif)
     xprintf("COUNT %d\n", count);
 #endif
   eth_ctx->currx = idx;
+  eth_ctx->rx_cnt += count;
+
+  /* resume rx if it ran out of descriptors */
+  if (count)
+    ETH->dma.rpdr = 0;
+
+  return count;
 }
 
-static void eth_irq(void *data)
+/* release the chains of frames that have gone out */
+static void poll_tx_desc(eth_ctx_t *eth_ctx)
 {
-  unsigned int dmasr;
+  unsigned int idx = eth_ctx->txclean;
 
-#if 0
+  while (idx != eth_ctx->curtx && !(tx_des[idx].des[0] & ETH_TDES0_OWN)) {
+    if (tx_pbuf[idx]) {
+      pbuf_free(tx_pbuf[idx]);
+      tx_pbuf[idx] = NULL;
+    }
+    if (++idx >= N_TX_DES)
+      idx = 0;
+  }
+  eth_ctx->txclean = idx;
+}
+
+static void tx_reset(eth_ctx_t *eth_ctx)
+{
+  unsigned int i;
+
+  for (i = 0; i < N_TX_DES; i++)
+    if (tx_pbuf[i]) {
+      pbuf_free(tx_pbuf[i]);
+      tx_pbuf[i] = NULL;
+    }
+  eth_ctx->txclean = 0;
+}
+
+static void eth_irq(void *data)
+{
   eth_ctx_t *eth_ctx = data;
-#endif
+  unsigned int dmasr;
 
 #if 0
   xprintf("irq\n");
@@ -312,20 +504,24 @@ static void eth_irq(void *data)
   FAST_LOG('n', "eth_irq %08x\n", dmasr, 0);
   ETH->dma.sr = 0xffffffff;
 
+  eth_ctx->irq_cnt++;
+
 #if 0
   xprintf("dmasr %08x\n", dmasr);
 #endif
 
   if (dmasr & ETH_DMASR_RS) {
 #if CONFIG_LWIP
-    sem_post(eth_wakeup);
+    /* rx stays masked until eth_input() has drained the ring */
+    ETH->dma.ier &= ~ETH_DMAIER_RIE;
+    event_set(eth_wakeup, ETH_EVENT_RX);
 #endif
   }
-#if 0
-  if (dmasr & ETH_DMASR_TS)
-    xprintf("tx done\n");
-
+  if (dmasr & ETH_DMASR_TS) {
+#if CONFIG_LWIP
+    event_set(eth_wakeup, ETH_EVENT_TX);
 #endif
+  }
   if (dmasr & ETH_DMASR_TPSS)
     xslog(LOG_ERR, "tx process stopped\n");
 
@@ -360,7 +556,6 @@ int hal_eth_init()
 {
   unsigned int i;
   int speed;
-  eth_des_t *d;
 
   ETH->dma.ier = 0;
 
@@ -386,18 +581,17 @@ int hal_eth_init()
   else
     ETH->mac.cr &= ~BIT(11);
 
-  for (i = 0; i < N_RX_DES; i++) {
-    d = &rx_des[i];
-
-    d->des[0] = ETH_RDES0_OWN;
-    d->des[1] = ETH_RDES1_RBS2(0) | ETH_RDES1_RBS1(ETH_PKT_LEN);
-    d->des[2] = (unsigned int)&rx_data[i];
-    d->des[3] = 0;
-  }
+#if ETH_RX_ZERO_COPY
+  rx_pool_init();
+#endif
 
-  d->des[1] |= ETH_RDES1_RER;
+  tx_reset(&eth_ctx);
+  memset(&eth_ctx, 0, sizeof(eth_ctx_t));
+  eth_ctx.rx_coal = CONFIG_ETH_RX_COAL ? CONFIG_ETH_RX_COAL : 1;
+  eth_ctx.rx_wdt = CONFIG_ETH_RX_WDT;
 
-  eth_ctx.currx = 0;
+  for (i = 0; i < N_RX_DES; i++)
+    rx_des_arm(&eth_ctx, i);
 
   memset(tx_des, 0, sizeof(tx_des));
 
@@ -405,12 +599,20 @@ int hal_eth_init()
 
   ETH->dma.tdlar = (unsigned int)&tx_des[0];
 
+  ETH->dma.rswtr = eth_ctx.rx_wdt & 0xff;
+
   ETH->dma.ier = ETH_DMAIER_ALL;
 
-  ETH->dma.omr = ETH_DMA_OMR_SR;   /* start rx */
+  /* checksum insertion needs the whole frame in the fifo */
+  ETH->dma.omr = ETH_DMA_OMR_SR | ETH_DMA_OMR_TSF;   /* start rx */
 
   ETH->mac.ffr = BIT(31) | BIT(0); /* promisc */
 
+  if (eth_csum)
+    ETH->mac.cr |= ETH_MACCR_IPCO;
+  else
+    ETH->mac.cr &= ~ETH_MACCR_IPCO;
+
   ETH->mac.cr |= BIT(3) | BIT(2);  /* enable tx,rx */
 
   irq_register("eth", eth_irq, (void *)&eth_ctx, 61);
@@ -452,6 +654,25 @@ void phy_write(unsigned int phy, unsigned int reg, unsigned int val)
     xslog(LOG_ERR, "timeout waiting for phy\n");
 }
 
+static struct netif *eth_nif;
+
+static void eth_csum_offload(int on)
+{
+  eth_csum = !!on;
+
+  if (eth_csum)
+    ETH->mac.cr |= ETH_MACCR_IPCO;
+  else
+    ETH->mac.cr &= ~ETH_MACCR_IPCO;
+
+  /* lwip still does icmp6, the mac only knows ipv4 icmp */
+  if (eth_nif)
+    NETIF_SET_CHECKSUM_CTRL(eth_nif, eth_csum ?
+                            (NETIF_CHECKSUM_GEN_ICMP6 |
+                             NETIF_CHECKSUM_CHECK_ICMP6) :
+                            NETIF_CHECKSUM_ENABLE_ALL);
+}
+
 int cmd_eth(int argc, char *argv[])
 {
   int v, i;
@@ -466,6 +687,38 @@ int cmd_eth(int argc, char *argv[])
       xprintf("%02x: %04x\n", i, v);
     }
     break;
+  case 'a':
+    eth_ctx.rx_miss += ETH->dma.mfbocr & 0xffff;
+    xprintf("rings rx %d tx %d\n", N_RX_DES, N_TX_DES);
+    xprintf("rx %u tx %u irq %u", eth_ctx.rx_cnt, eth_ctx.tx_cnt,
+            eth_ctx.irq_cnt);
+    if (eth_ctx.rx_cnt + eth_ctx.tx_cnt)
+      xprintf(" irq/100pkt %u", eth_ctx.irq_cnt * 100 /
+              (eth_ctx.rx_cnt + eth_ctx.tx_cnt));
+    xprintf("\n");
+    xprintf("rx miss %u drop %u\n", eth_ctx.rx_miss, eth_ctx.rx_drop);
+    xprintf("tx drop %u copy %u\n", eth_ctx.tx_drop, eth_ctx.tx_copy);
+    xprintf("coal %u wdt %u\n", eth_ctx.rx_coal, eth_ctx.rx_wdt);
+    xprintf("csum %s err %u\n", eth_csum ? "hw" : "sw",
+            eth_ctx.rx_csum_err);
+    break;
+  case 'k':
+    /* eth k [0|1] */
+    if (argc >= 3)
+      eth_csum_offload(strtoul(argv[2], NULL, 0));
+    xprintf("csum %s\n", eth_csum ? "hw" : "sw");
+    break;
+  case 'c':
+    /* eth c <frames> <wdt> */
+    if (argc >= 4) {
+      eth_ctx.rx_coal = strtoul(argv[2], NULL, 0);
+      if (eth_ctx.rx_coal == 0)
+        eth_ctx.rx_coal = 1;
+      eth_ctx.rx_wdt = strtoul(argv[3], NULL, 0) & 0xff;
+      ETH->dma.rswtr = eth_ctx.rx_wdt;
+    }
+    xprintf("coal %u wdt %u\n", eth_ctx.rx_coal, eth_ctx.rx_wdt);
+    break;
   }
   return 0;
 }
@@ -473,49 +726,104 @@ int cmd_eth(int argc, char *argv[])
 SHELL_CMD(eth, cmd_eth);
 
 #if CONFIG_LWIP
+/* the eth dma cannot reach the core coupled memory */
+static int tx_dma_ok(const void *p)
+{
+  unsigned int a = (unsigned int)p;
+
+  return !(a >= 0x10000000 && a < 0x10010000);
+}
+
 static err_t hal_eth_send(struct netif *netif, struct pbuf *p)
 {
-  int idx = eth_ctx.curtx;
+  unsigned int idx = eth_ctx.curtx, first = idx, last = idx;
+  unsigned int n = 0, len = 0, used, cic;
   eth_des_t *d;
-  unsigned char *dat;
   struct pbuf *q;
-  unsigned int len = 0;
+  int copy = 0;
 
-  dat = tx_data[idx];
-  for (q = p; q; q = q->next) {
-    unsigned int l = q->len;
+  poll_tx_desc(&eth_ctx);
 
-    memcpy(dat, q->payload, l);
+  /* one descriptor per segment, unless the chain has to be copied */
+  for (q = p; q; q = q->next)
+    if (q->len) {
+      if (!tx_dma_ok(q->payload))
+        copy = 1;
+      len += q->len;
+      n++;
+    }
+
+  if (n >= N_TX_DES)
+    copy = 1;
+  if (copy)
+    n = 1;
 
-    dat += l;
-    len += l;
+  used = (eth_ctx.curtx + N_TX_DES - eth_ctx.txclean) % N_TX_DES;
+  if (used + n >= N_TX_DES) {
+    FAST_LOG('e', "no free tx eth buffer\n", 0, 0);
+    eth_ctx.tx_drop++;
+    return ERR_MEM;
   }
 
-  d = &tx_des[idx];
+  /* insert ip header and payload checksums, pseudo header included */
+  cic = eth_csum ? ETH_TDES0_CIC(3) : 0;
 
-  if ((d->des[0] & ETH_TDES0_OWN) != 0) {
-    xslog(LOG_ERR, "No free tx buffer %08x\n", d->des[0]);
-    return -1;
-  }
+  if (copy) {
+    unsigned char *dat = tx_data[idx];
 
-  d->des[0] = ETH_TDES0_OWN | ETH_TDES0_IC | ETH_TDES0_LS | \
-              ETH_TDES0_FS;
-  d->des[1] = ETH_TDES1_TBS2(0) | ETH_TDES1_TBS1(len);
-  d->des[2] = (unsigned int)&tx_data[idx];
-  d->des[3] = 0;
+    for (q = p; q; q = q->next) {
+      memcpy(dat, q->payload, q->len);
+      dat += q->len;
+    }
+    eth_ctx.tx_copy++;
+
+    d = &tx_des[idx];
+    d->des[0] = cic | ((idx == N_TX_DES - 1) ? ETH_TDES0_TER : 0);
+    d->des[1] = ETH_TDES1_TBS2(0) | ETH_TDES1_TBS1(len);
+    d->des[2] = (unsigned int)&tx_data[idx];
+    d->des[3] = 0;
 
-  idx++;
+    if (++idx >= N_TX_DES)
+      idx = 0;
+  } else {
+    for (q = p; q; q = q->next) {
+      if (!q->len)
+        continue;
+
+      d = &tx_des[idx];
+      d->des[0] = cic | ((idx == N_TX_DES - 1) ? ETH_TDES0_TER : 0);
+      if (idx != first)
+        d->des[0] |= ETH_TDES0_OWN;
+      d->des[1] = ETH_TDES1_TBS2(0) | ETH_TDES1_TBS1(q->len);
+      d->des[2] = (unsigned int)q->payload;
+      d->des[3] = 0;
+
+      last = idx;
+      if (++idx >= N_TX_DES)
+        idx = 0;
+    }
 
-  if (idx >= N_TX_DES) {
-    d->des[0] |= ETH_TDES0_TER;
-    idx = 0;
+    /* lwip may reuse or free the chain once we return */
+    pbuf_ref(p);
+    tx_pbuf[last] = p;
   }
+
+  tx_des[last].des[0] |= ETH_TDES0_IC | ETH_TDES0_LS;
+  tx_des[first].des[0] |= ETH_TDES0_FS;
+
+  /* the first descriptor is handed over last so the dma never sees a
+     partial chain */
+  __DSB();
+
+  tx_des[first].des[0] |= ETH_TDES0_OWN;
+
   eth_ctx.curtx = idx;
+  eth_ctx.tx_cnt++;
 
   ETH->dma.omr |= ETH_DMA_OMR_ST; /* start tx */
   ETH->dma.tpdr = 0;
 
-  return 0;
+  return ERR_OK;
 }
 
 err_t eth_init(struct netif *nif)
@@ -537,11 +845,27 @@ err_t eth_init(struct netif *nif)
 
   hal_eth_init();
 
+  eth_nif = nif;
+  eth_csum_offload(eth_csum);
+
   return 0;
 }
 
 void eth_input(struct netif *nif)
 {
-  poll_rx_desc(&eth_ctx, nif);
+  poll_tx_desc(&eth_ctx);
+
+  /* over budget, come back after lwip has run with rx still masked */
+  if (poll_rx_desc(&eth_ctx, nif, CONFIG_ETH_RX_BUDGET) >=
+      CONFIG_ETH_RX_BUDGET) {
+    event_set(eth_wakeup, ETH_EVENT_RX);
+    return;
+  }
+
+  ETH->dma.ier |= ETH_DMAIER_RIE;
+
+  /* a frame that landed before rx was unmasked raised no interrupt */
+  if ((rx_des[eth_ctx.currx].des[0] & ETH_RDES0_OWN) == 0)
+    event_set(eth_wakeup, ETH_EVENT_RX);
 }
 #endif
@@ -38,6 +38,22 @@
 #include "lwip/etharp.h"
 #endif
 
+/* hand received frames to lwip in place instead of copying them into
+   PBUF_POOL pbufs */
+#ifndef CONFIG_ETH_RX_ZERO_COPY
+#define CONFIG_ETH_RX_ZERO_COPY 1
+#endif
+
+#if CONFIG_LWIP && CONFIG_ETH_RX_ZERO_COPY
+#define ETH_RX_ZERO_COPY 1
+#include <stddef.h>
+
+#include "bmos_mempool.h"
+#include "lwip/pbuf.h"
+#else
+#define ETH_RX_ZERO_COPY 0
+#endif
+
 #if STM32_H5XX
 #define ETH_IRQ 106
 #else
@@ -238,7 +254,7 @@ typedef struct {
 #define ETH_TDES3_SAIC(v) FIELD(3, 23, v)
 #define ETH_TDES3_THL(v) FIELD(4, 19, v)
 #define ETH_TDES3_TSE BIT(18)
-#define ETH_TDES3_CICTPL FIELD(2, 16, v) /* cksum/tcp_payload_len */
+#define ETH_TDES3_CIC(v) FIELD(2, 16, v) /* cksum/tcp_payload_len */
 #define ETH_TDES3_TPL BIT(15)
 #define ETH_TDES3_FL(v) FIELD(15, 0, v)
 
@@ -248,9 +264,16 @@ typedef struct {
 
 #define ETH_RDES3_OWN BIT(31)
 #define ETH_RDES3_IOC BIT(30)
+#define ETH_RDES3_RS1V BIT(26)
 #define ETH_RDES3_BUF2V BIT(25)
 #define ETH_RDES3_BUF1V BIT(24)
 
+#define ETH_RDES1_IPCE BIT(7)
+#define ETH_RDES1_IPHE BIT(3)
+
+#define ETH_MACCR_IPC BIT(27)
+#define ETH_MTLTXQOMR_TSF BIT(1)
+
 #define ETH_DMARXCR_ST BIT(0)
 #define ETH_DMATXCR_ST BIT(0)
 
@@ -268,8 +291,39 @@ typedef struct {
 #define ETH_DMACIER_TXSE BIT(1)
 #define ETH_DMACIER_TIE BIT(0)
 
-#define N_RX_DES 4
-#define N_TX_DES 4
+/* descriptor ring sizes, boards with the memory can go deeper */
+#ifndef CONFIG_ETH_RX_DES
+#define CONFIG_ETH_RX_DES 4
+#endif
+
+#ifndef CONFIG_ETH_TX_DES
+#define CONFIG_ETH_TX_DES 4
+#endif
+
+/* rx interrupt coalescing: interrupt every CONFIG_ETH_RX_COAL frames and
+   let the rx watchdog (units of 256 bus clocks) pick up the rest, a
+   watchdog of 0 interrupts on every frame */
+#ifndef CONFIG_ETH_RX_COAL
+#define CONFIG_ETH_RX_COAL 1
+#endif
+
+#ifndef CONFIG_ETH_RX_WDT
+#define CONFIG_ETH_RX_WDT 0
+#endif
+
+/* have the mac insert and verify ip/udp/tcp/icmp checksums, "eth k"
+   switches it at run time */
+#ifndef CONFIG_ETH_CSUM_OFFLOAD
+#define CONFIG_ETH_CSUM_OFFLOAD 1
+#endif
+
+/* frames received per eth_input() before lwip gets to run its timers */
+#ifndef CONFIG_ETH_RX_BUDGET
+#define CONFIG_ETH_RX_BUDGET 16
+#endif
+
+#define N_RX_DES CONFIG_ETH_RX_DES
+#define N_TX_DES CONFIG_ETH_TX_DES
 #define ETH_PKT_LEN 1524
 #define AETH_PKT_LEN ALIGN(ETH_PKT_LEN, 3)
 
@@ -279,11 +333,35 @@ typedef struct {
 #define ETHSECT
 #endif
 
+#if ETH_RX_ZERO_COPY
+/* spare buffers for frames lwip is still holding */
+#ifndef CONFIG_ETH_RX_BUFS
+#define CONFIG_ETH_RX_BUFS (2 * N_RX_DES)
+#endif
+
+typedef struct {
+  unsigned char data[AETH_PKT_LEN];
+  struct pbuf_custom pc;
+} eth_rx_buf_t;
+
+static eth_rx_buf_t rx_bufs[CONFIG_ETH_RX_BUFS] ETHSECT;
+static bmos_mempool_static_t rx_pool_static;
+static bmos_mempool_t *rx_pool;
+static eth_rx_buf_t *rx_buf[N_RX_DES];
+
+#define RX_DATA(idx) (rx_buf[idx]->data)
+#else
 static unsigned char rx_data[N_RX_DES][AETH_PKT_LEN] ETHSECT;
+
+#define RX_DATA(idx) (rx_data[idx])
+#endif
 static eth_des_t rx_des[N_RX_DES] ETHSECT;
 
 #if CONFIG_LWIP
+/* frames the dma cannot send in place are copied here */
 static unsigned char tx_data[N_TX_DES][AETH_PKT_LEN] ETHSECT;
+/* chain held until the frame ending at this descriptor is sent */
+static struct pbuf *tx_pbuf[N_TX_DES];
 #endif
 static eth_des_t tx_des[N_TX_DES] ETHSECT;
 
@@ -309,63 +387,149 @@ static eth_des_t tx_des[N_TX_DES] ETHSECT;
 typedef struct {
   unsigned int currx;
   unsigned int curtx;
+  unsigned int txclean;
+  unsigned int rx_coal;
+  unsigned int rx_wdt;
+  unsigned int rx_cnt;
+  unsigned int tx_cnt;
+  unsigned int irq_cnt;
+  unsigned int rx_miss;
+  unsigned int rx_drop;
+  unsigned int tx_drop;
+  unsigned int tx_copy;
+  unsigned int rx_csum_err;
 } eth_ctx_t;
 
 struct netif;
 struct pbuf;
 
-void poll_rx_desc(eth_ctx_t *eth_ctx, struct netif *nif)
+static int eth_csum = CONFIG_ETH_CSUM_OFFLOAD;
+
+static void rx_des_arm(eth_ctx_t *eth_ctx, unsigned int idx,
+                       unsigned char *buf)
 {
-  unsigned int idx = eth_ctx->currx;
-  eth_des_t *d;
+  eth_des_t *d = &rx_des[idx];
+  unsigned int des3 = ETH_RDES3_OWN | ETH_RDES3_BUF1V;
 
-#if CONFIG_LWIP
-  unsigned int rem;
-  struct pbuf *p, *q;
-  unsigned char *dat;
-#endif
+  /* without IOC the rx watchdog raises the interrupt */
+  if (eth_ctx->rx_wdt == 0 || (idx + 1) % eth_ctx->rx_coal == 0)
+    des3 |= ETH_RDES3_IOC;
 
-  d = &rx_des[idx];
+  d->des[0] = (unsigned int)buf;
+  d->des[1] = 0;
+  d->des[2] = 0;
+  d->des[3] = des3;
+}
 
-  while ((d->des[3] & ETH_RDES3_OWN) == 0) {
-#if CONFIG_LWIP
-    rem = d->des[3] & 0x7fff;
-    dat = rx_data[idx];
-#endif
+#if ETH_RX_ZERO_COPY
+/* lwip is done with the frame, the buffer goes back to the pool */
+static void rx_pbuf_free(struct pbuf *p)
+{
+  mempool_free(rx_pool, (char *)p - offsetof(eth_rx_buf_t, pc));
+}
 
-#if 0
-    xprintf("rx %d len: %d\n", idx, rem);
-#endif
+static void rx_pool_init(void)
+{
+  unsigned int i;
 
-#if CONFIG_LWIP
-    p = pbuf_alloc(PBUF_RAW, rem, PBUF_POOL);
-    if (p) {
-      err_t err;
+  if (!rx_pool) {
+    rx_pool = mempool_init_static(&rx_pool_static, "ethrx",
+                                  CONFIG_ETH_RX_BUFS, sizeof(eth_rx_buf_t),
+                                  rx_bufs);
+    XASSERT(rx_pool);
+  }
+
+  for (i = 0; i < N_RX_DES; i++)
+    if (!rx_buf[i]) {
+      rx_buf[i] = mempool_alloc(rx_pool);
+      XASSERT(rx_buf[i]);
+    }
+}
+
+static void poll_rx_frame(eth_ctx_t *eth_ctx, struct netif *nif,
+                          unsigned int idx, unsigned int len)
+{
+  eth_rx_buf_t *b = rx_buf[idx], *nb;
+  struct pbuf *p;
+
+  /* when lwip holds every spare buffer the frame is dropped and its
+     buffer reused */
+  nb = mempool_alloc(rx_pool);
+  if (!nb) {
+    FAST_LOG('e', "eth rx drop\n", 0, 0);
+    eth_ctx->rx_drop++;
+    return;
+  }
+
+  b->pc.custom_free_function = rx_pbuf_free;
+  p = pbuf_alloced_custom(PBUF_RAW, len, PBUF_REF, &b->pc, b->data,
+                          AETH_PKT_LEN);
+
+  rx_buf[idx] = nb;
+
+  if (nif->input(p, nif) != ERR_OK) {
+    debug_printf("lwip input error");
+    pbuf_free(p);
+  }
+}
+#elif CONFIG_LWIP
+static void poll_rx_frame(eth_ctx_t *eth_ctx, struct netif *nif,
+                          unsigned int idx, unsigned int rem)
+{
+  unsigned char *dat = rx_data[idx];
+  struct pbuf *p, *q;
 
-      for (q = p; q && (rem > 0); q = q->next) {
-        unsigned int cnt = q->len;
+  p = pbuf_alloc(PBUF_RAW, rem, PBUF_POOL);
+  if (p) {
+    err_t err;
 
-        if (rem < cnt)
-          cnt = rem;
+    for (q = p; q && (rem > 0); q = q->next) {
+      unsigned int cnt = q->len;
 
-        memcpy(q->payload, dat, cnt);
+      if (rem < cnt)
+        cnt = rem;
 
-        dat += cnt;
-        rem -= cnt;
-      }
+      memcpy(q->payload, dat, cnt);
 
-      err = nif->input(p, nif);
-      if (err != ERR_OK) {
-        debug_printf("lwip input error");
-        pbuf_free(p);
-      }
+      dat += cnt;
+      rem -= cnt;
     }
+
+    err = nif->input(p, nif);
+    if (err != ERR_OK) {
+      debug_printf("lwip input error");
+      pbuf_free(p);
+    }
+  } else
+    eth_ctx->rx_drop++;
+}
 #endif
 
-    d->des[0] = (unsigned int)&rx_data[idx];
-    d->des[1] = 0;
-    d->des[2] = 0;
-    d->des[3] = ETH_RDES3_OWN | ETH_RDES3_IOC | ETH_RDES3_BUF1V;
+unsigned int poll_rx_desc(eth_ctx_t *eth_ctx, struct netif *nif,
+                          unsigned int budget)
+{
+  unsigned int idx = eth_ctx->currx, count = 0;
+  eth_des_t *d;
+
+  d = &rx_des[idx];
+
+  while ((d->des[3] & ETH_RDES3_OWN) == 0 && count < budget) {
+    count++;
+
+#if 0
+    xprintf("rx %d len: %d\n", idx, d->des[3] & 0x7fff);
+#endif
+
+#if CONFIG_LWIP
+    /* lwip no longer checks, so frames the mac flagged go here */
+    if (eth_csum && (d->des[3] & ETH_RDES3_RS1V) &&
+        (d->des[1] & (ETH_RDES1_IPCE | ETH_RDES1_IPHE)))
+      eth_ctx->rx_csum_err++;
+    else
+      poll_rx_frame(eth_ctx, nif, idx, d->des[3] & 0x7fff);
+#endif
+
+    rx_des_arm(eth_ctx, idx, RX_DATA(idx));
 
     idx++;
     if (idx >= N_RX_DES)
@@ -373,17 +537,53 @@ void poll_rx_desc(eth_ctx_t *eth_ctx, struct netif *nif)
     d = &rx_des[idx];
   }
   eth_ctx->currx = idx;
+  eth_ctx->rx_cnt += count;
 
   ETH->dmacrxdtpr = (unsigned int)&rx_des[N_RX_DES];
+
+  return count;
 }
 
+#if CONFIG_LWIP
+/* release the chains of frames that have gone out */
+static void poll_tx_desc(eth_ctx_t *eth_ctx)
+{
+  unsigned int idx = eth_ctx->txclean;
+
+  while (idx != eth_ctx->curtx && !(tx_des[idx].des[3] & ETH_TDES3_OWN)) {
+    if (tx_pbuf[idx]) {
+      pbuf_free(tx_pbuf[idx]);
+      tx_pbuf[idx] = NULL;
+    }
+    if (++idx >= N_TX_DES)
+      idx = 0;
+  }
+  eth_ctx->txclean = idx;
+}
+
+static void tx_reset(eth_ctx_t *eth_ctx)
+{
+  unsigned int i;
+
+  for (i = 0; i < N_TX_DES; i++)
+    if (tx_pbuf[i]) {
+      pbuf_free(tx_pbuf[i]);
+      tx_pbuf[i] = NULL;
+    }
+  eth_ctx->txclean = 0;
+}
+#endif
+
 static void eth_irq(void *data)
 {
+  eth_ctx_t *eth_ctx = data;
   unsigned int dmacsr;
 
   dmacsr = ETH->dmacsr;
   ETH->dmacsr = 0xffffffff;
 
+  eth_ctx->irq_cnt++;
+
 #if 0
   if (dmacsr & ETH_DMACSR_TI)
     debug_printf("tx\n");
@@ -394,9 +594,16 @@ static void eth_irq(void *data)
 
 #endif
 
+#if CONFIG_LWIP
+  if (dmacsr & ETH_DMACSR_TI)
+    event_set(eth_wakeup, ETH_EVENT_TX);
+#endif
+
   if (dmacsr & ETH_DMACSR_RI) {
 #if CONFIG_LWIP
-    sem_post(eth_wakeup);
+    /* rx stays masked until eth_input() has drained the ring */
+    ETH->dmacier &= ~ETH_DMACIER_RIE;
+    event_set(eth_wakeup, ETH_EVENT_RX);
 #endif
 
 #if 0
@@ -457,14 +664,19 @@ static int hal_eth_init(unsigned int flags)
 
   ETH->dmasbmr = BIT(0);
 
-  for (i = 0; i < N_RX_DES; i++) {
-    eth_des_t *d = &rx_des[i];
+#if ETH_RX_ZERO_COPY
+  rx_pool_init();
+#endif
 
-    d->des[0] = (unsigned int)&rx_data[i];
-    d->des[1] = 0;
-    d->des[2] = 0;
-    d->des[3] = ETH_RDES3_OWN | ETH_RDES3_IOC | ETH_RDES3_BUF1V;
-  }
+#if CONFIG_LWIP
+  tx_reset(&eth_ctx);
+#endif
+  memset(&eth_ctx, 0, sizeof(eth_ctx_t));
+  eth_ctx.rx_coal = CONFIG_ETH_RX_COAL ? CONFIG_ETH_RX_COAL : 1;
+  eth_ctx.rx_wdt = CONFIG_ETH_RX_WDT;
+
+  for (i = 0; i < N_RX_DES; i++)
+    rx_des_arm(&eth_ctx, i, RX_DATA(i));
 
   memset(tx_des, 0, sizeof(tx_des));
 
@@ -480,6 +692,7 @@ static int hal_eth_init(unsigned int flags)
 
   ETH->dmactxcr = (0x20U << 16);
   ETH->dmacrxcr = (0x20U << 16) | (AETH_PKT_LEN << 1);
+  ETH->dmacrxiwtr = eth_ctx.rx_wdt & 0xff;
 
 #if 0
   ETH->dmacier =
@@ -493,7 +706,8 @@ static int hal_eth_init(unsigned int flags)
     ETH_DMACIER_ETIE | ETH_DMACIER_RIE | ETH_DMACIER_TIE;
 #endif
 
-  ETH->mtltxqomr = (0 << 16) | (0 << 4) | (2 << 2);
+  /* checksum insertion needs the whole frame in the fifo */
+  ETH->mtltxqomr = (0 << 16) | (0 << 4) | (2 << 2) | ETH_MTLTXQOMR_TSF;
   ETH->mtlrxqomr = 0;
 
   /* mac address MACA */
@@ -531,6 +745,9 @@ static int hal_eth_init(unsigned int flags)
   if (speed & PHY_FULL_DUPLEX)
     maccr |= BIT(13);
 
+  if (eth_csum)
+    maccr |= ETH_MACCR_IPC;
+
   maccr |= BIT(1) | BIT(0);  /* enable tx and rx */
 
   ETH->maccr = maccr;
@@ -539,8 +756,6 @@ static int hal_eth_init(unsigned int flags)
 
   ETH->dmacrxcr |= ETH_DMARXCR_ST; /* enable rx dma */
 
-  memset(&eth_ctx, 0, sizeof(eth_ctx_t));
-
   irq_register("eth", eth_irq, &eth_ctx, ETH_IRQ);
 
   return 0;
@@ -580,6 +795,27 @@ void phy_write(unsigned int phy, unsigned int reg, unsigned int val)
     debug_printf("timeout waiting for phy\n");
 }
 
+#if CONFIG_LWIP
+static struct netif *eth_nif;
+
+static void eth_csum_offload(int on)
+{
+  eth_csum = !!on;
+
+  if (eth_csum)
+    ETH->maccr |= ETH_MACCR_IPC;
+  else
+    ETH->maccr &= ~ETH_MACCR_IPC;
+
+  /* lwip still does icmp6, the mac only knows ipv4 icmp */
+  if (eth_nif)
+    NETIF_SET_CHECKSUM_CTRL(eth_nif, eth_csum ?
+                            (NETIF_CHECKSUM_GEN_ICMP6 |
+                             NETIF_CHECKSUM_CHECK_ICMP6) :
+                            NETIF_CHECKSUM_ENABLE_ALL);
+}
+#endif
+
 int cmd_eth(int argc, char *argv[])
 {
   int v, i, phyaddr = 0;
@@ -606,6 +842,38 @@ int cmd_eth(int argc, char *argv[])
   case 'a':
     xprintf("dmaisr %08x\n", ETH->dmaisr);
     xprintf("dmacsr %08x\n", ETH->dmacsr);
+    eth_ctx.rx_miss += ETH->dmacmfcr & 0x7ff;
+    xprintf("rings rx %d tx %d\n", N_RX_DES, N_TX_DES);
+    xprintf("rx %u tx %u irq %u", eth_ctx.rx_cnt, eth_ctx.tx_cnt,
+            eth_ctx.irq_cnt);
+    if (eth_ctx.rx_cnt + eth_ctx.tx_cnt)
+      xprintf(" irq/100pkt %u", eth_ctx.irq_cnt * 100 /
+              (eth_ctx.rx_cnt + eth_ctx.tx_cnt));
+    xprintf("\n");
+    xprintf("rx miss %u drop %u\n", eth_ctx.rx_miss, eth_ctx.rx_drop);
+    xprintf("tx drop %u copy %u\n", eth_ctx.tx_drop, eth_ctx.tx_copy);
+    xprintf("coal %u wdt %u\n", eth_ctx.rx_coal, eth_ctx.rx_wdt);
+    xprintf("csum %s err %u\n", eth_csum ? "hw" : "sw",
+            eth_ctx.rx_csum_err);
+    break;
+#if CONFIG_LWIP
+  case 'k':
+    /* eth k [0|1] */
+    if (argc >= 3)
+      eth_csum_offload(strtoul(argv[2], NULL, 0));
+    xprintf("csum %s\n", eth_csum ? "hw" : "sw");
+    break;
+#endif
+  case 'c':
+    /* eth c <frames> <wdt> */
+    if (argc >= 4) {
+      eth_ctx.rx_coal = strtoul(argv[2], NULL, 0);
+      if (eth_ctx.rx_coal == 0)
+        eth_ctx.rx_coal = 1;
+      eth_ctx.rx_wdt = strtoul(argv[3], NULL, 0) & 0xff;
+      ETH->dmacrxiwtr = eth_ctx.rx_wdt;
+    }
+    xprintf("coal %u wdt %u\n", eth_ctx.rx_coal, eth_ctx.rx_wdt);
     break;
   }
   return 0;
@@ -614,47 +882,109 @@ int cmd_eth(int argc, char *argv[])
 SHELL_CMD(eth, cmd_eth);
 
 #if CONFIG_LWIP
+/* the eth dma cannot reach the tightly coupled memories */
+static int tx_dma_ok(const void *p)
+{
+#if STM32_H7XX
+  unsigned int a = (unsigned int)p;
+
+  return !(a < 0x00010000 || (a >= 0x20000000 && a < 0x20020000));
+#else
+  (void)p;
+
+  return 1;
+#endif
+}
+
 static err_t hal_eth_send(struct netif *netif, struct pbuf *p)
 {
-  int idx = eth_ctx.curtx;
+  unsigned int idx = eth_ctx.curtx, first = idx, last = idx;
+  unsigned int n = 0, len = 0, used, cic;
   eth_des_t *d;
-  unsigned char *dat;
   struct pbuf *q;
-  unsigned int len = 0;
+  int copy = 0;
 
-  d = &tx_des[idx];
+  poll_tx_desc(&eth_ctx);
 
-  if ((d->des[3] & ETH_TDES3_OWN) != 0) {
-    FAST_LOG('e', "no free tx eth buffer\n", 0, 0);
-    return -1;
-  }
+  /* one descriptor per segment, unless the chain has to be copied */
+  for (q = p; q; q = q->next)
+    if (q->len) {
+      if (!tx_dma_ok(q->payload))
+        copy = 1;
+      len += q->len;
+      n++;
+    }
 
-  dat = tx_data[idx];
-  for (q = p; q; q = q->next) {
-    unsigned int l = q->len;
+  XASSERT(len <= ETH_PKT_LEN);
 
-    memcpy(dat, q->payload, l);
+  if (n >= N_TX_DES)
+    copy = 1;
+  if (copy)
+    n = 1;
 
-    dat += l;
-    len += l;
+  used = (eth_ctx.curtx + N_TX_DES - eth_ctx.txclean) % N_TX_DES;
+  if (used + n >= N_TX_DES) {
+    FAST_LOG('e', "no free tx eth buffer\n", 0, 0);
+    eth_ctx.tx_drop++;
+    return ERR_MEM;
   }
 
-  XASSERT(len <= ETH_PKT_LEN);
-
 #if 0
-  xprintf("tx %d len %d\n", idx, len);
+  xprintf("tx %d len %d n %d\n", idx, len, n);
 #endif
 
-  d->des[0] = (unsigned int)&tx_data[idx];
-  d->des[1] = 0;
-  d->des[2] = ETH_TDES2_IOC | ETH_TDES2_B1L(len);
-  d->des[3] = ETH_TDES3_OWN | ETH_TDES3_FD | ETH_TDES3_LD | \
-              ETH_TDES3_FL(len);
+  /* insert ip header and payload checksums, pseudo header included */
+  cic = eth_csum ? ETH_TDES3_CIC(3) : 0;
 
-  idx++;
+  if (copy) {
+    unsigned char *dat = tx_data[idx];
 
-  if (idx >= N_TX_DES)
-    idx = 0;
+    for (q = p; q; q = q->next) {
+      memcpy(dat, q->payload, q->len);
+      dat += q->len;
+    }
+    eth_ctx.tx_copy++;
+
+    d = &tx_des[idx];
+    d->des[0] = (unsigned int)tx_data[idx];
+    d->des[1] = 0;
+    d->des[2] = ETH_TDES2_B1L(len);
+    d->des[3] = ETH_TDES3_FL(len) | cic;
+
+    if (++idx >= N_TX_DES)
+      idx = 0;
+  } else {
+    for (q = p; q; q = q->next) {
+      if (!q->len)
+        continue;
+
+      d = &tx_des[idx];
+      d->des[0] = (unsigned int)q->payload;
+      d->des[1] = 0;
+      d->des[2] = ETH_TDES2_B1L(q->len);
+      d->des[3] = ETH_TDES3_FL(len) | cic;
+      if (idx != first)
+        d->des[3] |= ETH_TDES3_OWN;
+
+      last = idx;
+      if (++idx >= N_TX_DES)
+        idx = 0;
+    }
+
+    /* lwip may reuse or free the chain once we return */
+    pbuf_ref(p);
+    tx_pbuf[last] = p;
+  }
+
+  tx_des[last].des[2] |= ETH_TDES2_IOC;
+  tx_des[last].des[3] |= ETH_TDES3_LD;
+  tx_des[first].des[3] |= ETH_TDES3_FD;
+
+  /* the first descriptor is handed over last so the dma never sees a
+     partial chain */
+  __DSB();
+
+  tx_des[first].des[3] |= ETH_TDES3_OWN;
 
   __DSB();
 
@@ -663,10 +993,11 @@ static err_t hal_eth_send(struct netif *netif, struct pbuf *p)
   __DSB();
 
   eth_ctx.curtx = idx;
+  eth_ctx.tx_cnt++;
 
   ETH->dmactxcr |= ETH_DMATXCR_ST; /* enable tx dma */
 
-  return 0;
+  return ERR_OK;
 }
 
 static hal_eth_config_t hal_eth_config_default = {
@@ -698,11 +1029,27 @@ err_t eth_init(struct netif *nif)
   if (hal_eth_init(config.flags) < 0)
     return -1;
 
+  eth_nif = nif;
+  eth_csum_offload(eth_csum);
+
   return 0;
 }
 
 void eth_input(struct netif *nif)
 {
-  poll_rx_desc(&eth_ctx, nif);
+  poll_tx_desc(&eth_ctx);
+
+  /* over budget, come back after lwip has run with rx still masked */
+  if (poll_rx_desc(&eth_ctx, nif, CONFIG_ETH_RX_BUDGET) >=
+      CONFIG_ETH_RX_BUDGET) {
+    event_set(eth_wakeup, ETH_EVENT_RX);
+    return;
+  }
+
+  ETH->dmacier |= ETH_DMACIER_RIE;
+
+  /* a frame that landed before rx was unmasked raised no interrupt */
+  if ((rx_des[eth_ctx.currx].des[3] & ETH_RDES3_OWN) == 0)
+    event_set(eth_wakeup, ETH_EVENT_RX);
 }
 #endif
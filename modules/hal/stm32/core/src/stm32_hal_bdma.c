@@ -120,6 +120,13 @@ static unsigned int stm32_bdma_irq_ack(void *base, unsigned int chan)
   return rstatus;
 }
 
+static unsigned int stm32_bdma_get_count(void *base, unsigned int chan)
+{
+  volatile stm32_bdma_t *d = base;
+
+  return d->chan[chan].cndtr & 0xffff;
+}
+
 static void stm32_bdma_trans(void *base, unsigned int chan,
                              void *src, void *dst, unsigned int n,
                              dma_attr_t attr)
@@ -186,5 +193,6 @@ dma_controller_t stm32_bdma_controller = {
   stm32_bdma_set_chan,
   stm32_bdma_en,
   stm32_bdma_start,
-  stm32_bdma_irq_ack
+  stm32_bdma_irq_ack,
+  stm32_bdma_get_count
 };
@@ -117,6 +117,13 @@ static unsigned int stm32_dma_irq_ack(void *addr, unsigned int chan)
   return rstatus;
 }
 
+static unsigned int stm32_dma_get_count(void *addr, unsigned int chan)
+{
+  stm32_dma_t *d = addr;
+
+  return d->chan[chan].ndtr & 0xffff;
+}
+
 static void stm32_dma_en(void *addr, unsigned int chan, int en)
 {
   stm32_dma_t *d = addr;
@@ -224,5 +231,6 @@ dma_controller_t stm32_dma_controller = {
   stm32_dma_set_chan,
   stm32_dma_en,
   stm32_dma_start,
-  stm32_dma_irq_ack
+  stm32_dma_irq_ack,
+  stm32_dma_get_count
 };
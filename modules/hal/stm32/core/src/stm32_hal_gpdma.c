@@ -389,6 +389,13 @@ static void stm32_gpdma_en(void *addr, unsigned int chan, int en)
     c->cr &= ~GPDMA_CR_EN;
 }
 
+static unsigned int stm32_gpdma_get_count(void *addr, unsigned int chan)
+{
+  stm32_gpdma_t *d = addr;
+
+  return d->chan[chan].br1 & 0xffff;
+}
+
 static void stm32_gpdma_start(void *addr, unsigned int chan)
 {
   stm32_gpdma_t *d = addr;
@@ -465,5 +472,6 @@ dma_controller_t stm32_gpdma_controller = {
   stm32_gpdma_set_chan,
   stm32_gpdma_en,
   stm32_gpdma_start,
-  stm32_gpdma_irq_ack
+  stm32_gpdma_irq_ack,
+  stm32_gpdma_get_count
 };
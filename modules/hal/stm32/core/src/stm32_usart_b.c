@@ -30,6 +30,7 @@
 #include "hal_int.h"
 #include "hal_uart.h"
 #include "hal_cpu.h"
+#include "hal_dma.h"
 #include "io.h"
 #include "stm32_hal.h"
 #include "xassert.h"
@@ -80,6 +81,8 @@ typedef struct {
 
 #define USART_CR3_RXFTIE BIT(28)
 #define USART_CR3_RXFTCFG_OFS 25
+#define USART_CR3_DMAR BIT(6)
+#define USART_CR3_DMAT BIT(7)
 
 #define USART_FIFO_THRES_1_8 0
 #define USART_FIFO_THRES_1_4 1
@@ -191,14 +194,21 @@ static void usart_tx(uart_t *u, unsigned int isr)
     len = u->data_len;
     data = u->data;
   } else {
-    m = op_msg_get(u->txq);
-    if (!m) {
-      if (u->flags & STM32_UART_FIFO)
-        usart->cr1 &= ~USART_CR1_TXFEIE;
-      else
-        usart->cr1 &= ~USART_CR1_TXEIE;
-      return;
+    if (u->tx_pos == u->tx_cnt) {
+      /* the whole batch has been sent, return it and fetch the next */
+      if (u->tx_cnt)
+        op_msg_return_n(u->tx_batch, u->tx_cnt);
+      u->tx_pos = 0;
+      u->tx_cnt = op_msg_get_n(u->txq, u->tx_batch, CONFIG_UART_TX_BATCH);
+      if (u->tx_cnt == 0) {
+        if (u->flags & STM32_UART_FIFO)
+          usart->cr1 &= ~USART_CR1_TXFEIE;
+        else
+          usart->cr1 &= ~USART_CR1_TXEIE;
+        return;
+      }
     }
+    m = u->tx_batch[u->tx_pos++];
     len = m->len;
     data = BMOS_OP_MSG_GET_DATA(m);
   }
@@ -221,7 +231,6 @@ static void usart_tx(uart_t *u, unsigned int isr)
   }
 
   if (len == 0) {
-    op_msg_return(m);
     u->msg = 0;
   } else {
     u->msg = m;
@@ -288,6 +297,126 @@ static void rx_fifo(uart_t *u, unsigned int isr)
     op_msg_put(u->rxq, m, u->op, count);
 }
 
+/* the dma writes straight into a pool message, u->rx_msg. On idle or a
+   full message it's handed on as is and the dma moves to the next one, so
+   nothing is copied and the buffer is held until op_msg_return(). Without
+   a free message the data is dropped and the current one is used again */
+static void dma_rx_next(uart_t *u)
+{
+  stm32_usart_b_t *usart = (stm32_usart_b_t *)u->base;
+  dma_attr_t attr;
+
+  attr.ssiz = DMA_SIZ_1;
+  attr.dsiz = DMA_SIZ_1;
+  attr.dir = DMA_DIR_FROM;
+  attr.prio = 0;
+  attr.sinc = 0;
+  attr.dinc = 1;
+  attr.irq = 1;
+  attr.circ = 0;
+  attr.irq_half = 0;
+
+  dma_trans(u->dma_num, u->rx_dma_chan, (void *)&usart->rdr,
+            BMOS_OP_MSG_GET_DATA(u->rx_msg), u->msg_len, attr);
+  dma_en(u->dma_num, u->rx_dma_chan, 1);
+}
+
+static void dma_rx(uart_t *u)
+{
+  bmos_op_msg_t *m;
+  unsigned int len, saved;
+
+  /* both the usart idle and the dma complete irqs get here */
+  saved = interrupt_disable();
+
+  dma_en(u->dma_num, u->rx_dma_chan, 0);
+  len = u->msg_len - dma_get_count(u->dma_num, u->rx_dma_chan);
+
+  if (len > 0) {
+    m = op_msg_get(u->pool);
+    if (!m) {
+      u->stats.overrun++;
+      FAST_LOG('u', "rx overrun: discarded %d\n", len, 0);
+    } else {
+      op_msg_put(u->rxq, u->rx_msg, u->op, len);
+      u->rx_msg = m;
+    }
+  }
+
+  dma_rx_next(u);
+
+  interrupt_enable(saved);
+}
+
+static void usart_dma_isr(void *data)
+{
+  uart_t *u = (uart_t *)data;
+
+  (void)dma_irq_ack(u->dma_num, u->rx_dma_chan);
+
+  dma_rx(u);
+}
+
+static void dma_rx_start(uart_t *u)
+{
+  stm32_usart_b_t *usart = (stm32_usart_b_t *)u->base;
+
+  u->rx_msg = op_msg_get(u->pool);
+  XASSERT(u->rx_msg);
+
+  dma_set_chan(u->dma_num, u->rx_dma_chan, u->rx_dma_devid);
+  irq_register(u->name, usart_dma_isr, u, u->rx_dma_irq);
+
+  usart->cr3 |= USART_CR3_DMAR;
+  dma_rx_next(u);
+}
+
+/* start the next queued message, u->msg is the one in flight. Messages
+   are fetched and returned in batches like the interrupt driven path */
+static void dma_tx_next(uart_t *u)
+{
+  stm32_usart_b_t *usart = (stm32_usart_b_t *)u->base;
+  bmos_op_msg_t *m;
+  dma_attr_t attr;
+
+  u->msg = 0;
+
+  do {
+    if (u->tx_pos == u->tx_cnt) {
+      if (u->tx_cnt)
+        op_msg_return_n(u->tx_batch, u->tx_cnt);
+      u->tx_pos = 0;
+      u->tx_cnt = op_msg_get_n(u->txq, u->tx_batch, CONFIG_UART_TX_BATCH);
+      if (u->tx_cnt == 0)
+        return;
+    }
+    m = u->tx_batch[u->tx_pos++];
+  } while (m->len == 0);
+
+  attr.ssiz = DMA_SIZ_1;
+  attr.dsiz = DMA_SIZ_1;
+  attr.dir = DMA_DIR_TO;
+  attr.prio = 0;
+  attr.sinc = 1;
+  attr.dinc = 0;
+  attr.irq = 1;
+  attr.circ = 0;
+  attr.irq_half = 0;
+
+  u->msg = m;
+  dma_trans(u->dma_num, u->tx_dma_chan, BMOS_OP_MSG_GET_DATA(m),
+            (void *)&usart->tdr, m->len, attr);
+  dma_en(u->dma_num, u->tx_dma_chan, 1);
+}
+
+static void usart_dma_tx_isr(void *data)
+{
+  uart_t *u = (uart_t *)data;
+
+  if (dma_irq_ack(u->dma_num, u->tx_dma_chan) & DMA_IRQ_STATUS_FULL)
+    dma_tx_next(u);
+}
+
 static void usart_isr(void *data)
 {
   uart_t *u = (uart_t *)data;
@@ -306,13 +435,16 @@ static void usart_isr(void *data)
   if (isr & UART_ISR_IDLE) {
     usart->icr = UART_ISR_IDLE;
 
-    if (u->flags & STM32_UART_FIFO)
+    if (u->flags & STM32_UART_DMA_RX)
+      dma_rx(u);
+    else if (u->flags & STM32_UART_FIFO)
       rx_fifo(u, isr);
     else if (circ_buf_used(&u->cb) > 0)
       sendcb(u);
   }
 
-  if (isr & UART_ISR_RXFT)
+  /* with dma rx the fifo stays on but belongs to the dma */
+  if ((isr & UART_ISR_RXFT) && !(u->flags & STM32_UART_DMA_RX))
     rx_fifo(u, isr);
   else if ((isr & UART_ISR_RXNE) && (cr1 & USART_CR1_RXNEIE)) {
     unsigned char c;
@@ -337,7 +469,14 @@ static void _put(void *p)
   uart_t *u = (uart_t *)p;
   stm32_usart_b_t *usart = (stm32_usart_b_t *)u->base;
 
-  if (u->flags & STM32_UART_FIFO)
+  if (u->flags & STM32_UART_DMA_TX) {
+    unsigned int saved = interrupt_disable();
+
+    if (!u->msg)
+      dma_tx_next(u);
+
+    interrupt_enable(saved);
+  } else if (u->flags & STM32_UART_FIFO)
     usart->cr1 |= USART_CR1_TXFEIE;
   else
     usart->cr1 |= USART_CR1_TXEIE;
@@ -348,6 +487,9 @@ static void _put_pool(void *p)
   unsigned int saved;
   uart_t *u = (uart_t *)p;
 
+  if (u->flags & STM32_UART_DMA_RX)
+    return;
+
   saved = interrupt_disable();
 
   if (circ_buf_used(&u->cb) > 0)
@@ -381,7 +523,11 @@ bmos_queue_t *uart_open(uart_t *u, unsigned int baud, bmos_queue_t *rxq,
 
   u->msg_len = (1U << msg_pow2);
 
-  if (u->flags & STM32_UART_FIFO) {
+  if (u->flags & STM32_UART_DMA_RX) {
+    /* the fifo covers the gap while the dma moves to the next message */
+    if (u->flags & STM32_UART_FIFO)
+      cr1 |= USART_CR1_FIFOEN;
+  } else if (u->flags & STM32_UART_FIFO) {
     cr1 |= USART_CR1_FIFOEN;
     reg_set_field(&usart->cr3, 3, USART_CR3_RXFTCFG_OFS, USART_FIFO_THRES_7_8);
     usart->cr3 |= USART_CR3_RXFTIE;
@@ -411,6 +557,15 @@ bmos_queue_t *uart_open(uart_t *u, unsigned int baud, bmos_queue_t *rxq,
 
   irq_register(u->name, usart_isr, u, u->irq);
 
+  if (u->flags & STM32_UART_DMA_RX)
+    dma_rx_start(u);
+
+  if (u->flags & STM32_UART_DMA_TX) {
+    dma_set_chan(u->dma_num, u->tx_dma_chan, u->tx_dma_devid);
+    irq_register(u->name, usart_dma_tx_isr, u, u->tx_dma_irq);
+    usart->cr3 |= USART_CR3_DMAT;
+  }
+
   return u->txq;
 }
 #endif
@@ -37,6 +37,7 @@ int strncmp(const char *s1, const char *s2, size_t n);
 char *strchr(const char *s, int c);
 int memcmp(const void *_s1, const void *_s2, size_t n);
 void *memcpy(void *dest, const void *src, size_t n);
+void *memmove(void *dest, const void *src, size_t n);
 void *memset(void *p, int v, size_t s);
 int atoi(const char *nptr);
 int abs(int j);
@@ -130,25 +131,66 @@ unsigned int scani(const char *ptr, unsigned int max_len, int *val)
   return i;
 }
 
-size_t strlen(const char *s)
+/* the word loops below must not be turned back into calls to themselves */
+#define LIBC_MEM __attribute__((optimize("no-tree-loop-distribute-patterns")))
+
+typedef unsigned int __attribute__((may_alias)) word_t;
+#if __ARM_FEATURE_UNALIGNED
+typedef unsigned int __attribute__((may_alias, aligned(1))) uword_t;
+#endif
+
+#define WORD_MASK (sizeof(word_t) - 1)
+#define ONES 0x01010101U
+#define HIGHS 0x80808080U
+#define HAS_ZERO(_w_) (((_w_) - ONES) & ~(_w_) & HIGHS)
+
+LIBC_MEM size_t strlen(const char *s)
 {
-  size_t count = 0;
+  const char *p = s;
+  const word_t *w;
 
-  while (*s++)
-    count++;
+  while ((unsigned int)p & WORD_MASK) {
+    if (!*p)
+      return p - s;
+    p++;
+  }
 
-  return count;
+  /* aligned word reads never cross into an unmapped page */
+  for (w = (const word_t *)p; !HAS_ZERO(*w); w++)
+    ;
+
+  for (p = (const char *)w; *p; p++)
+    ;
+
+  return p - s;
 }
 
-int memcmp(const void *_s1, const void *_s2, size_t n)
+LIBC_MEM int memcmp(const void *_s1, const void *_s2, size_t n)
 {
   const unsigned char *s1, *s2;
-  size_t i;
 
   s1 = _s1;
   s2 = _s2;
 
-  for (i = 0; i < n; i++) {
+  if (n >= 8 && (((unsigned int)s1 ^ (unsigned int)s2) & WORD_MASK) == 0) {
+    while ((unsigned int)s1 & WORD_MASK) {
+      if (*s1 != *s2)
+        return *s1 < *s2 ? -1 : 1;
+      s1++;
+      s2++;
+      n--;
+    }
+
+    /* skip equal words, the byte loop finds the difference */
+    while (n >= sizeof(word_t) &&
+           *(const word_t *)s1 == *(const word_t *)s2) {
+      s1 += sizeof(word_t);
+      s2 += sizeof(word_t);
+      n -= sizeof(word_t);
+    }
+  }
+
+  while (n--) {
     unsigned char c1 = *s1++;
     unsigned char c2 = *s2++;
     if (c1 < c2)
@@ -160,24 +202,92 @@ int memcmp(const void *_s1, const void *_s2, size_t n)
   return 0;
 }
 
-void *memcpy(void *dest, const void *src, size_t n)
+/* forward copy, all loads of a block are done before its stores so it
+   is also safe for overlapping copies with dest below src */
+static LIBC_MEM void _copy_fwd(unsigned char *d, const unsigned char *s,
+                               size_t n)
 {
-  unsigned int i;
-  unsigned char *d = dest;
-  const unsigned char *s = src;
+  if (n >= 8) {
+    while ((unsigned int)d & WORD_MASK) {
+      *d++ = *s++;
+      n--;
+    }
+
+    if (((unsigned int)s & WORD_MASK) == 0) {
+      word_t *dw = __builtin_assume_aligned(d, 4);
+      const word_t *sw = __builtin_assume_aligned(s, 4);
+
+      /* 4 words at a time to allow ldm/stm */
+      for (; n >= 16; n -= 16) {
+        word_t w0 = sw[0], w1 = sw[1], w2 = sw[2], w3 = sw[3];
+
+        dw[0] = w0;
+        dw[1] = w1;
+        dw[2] = w2;
+        dw[3] = w3;
+        dw += 4;
+        sw += 4;
+      }
+
+      for (; n >= 4; n -= 4)
+        *dw++ = *sw++;
+
+      d = (unsigned char *)dw;
+      s = (const unsigned char *)sw;
+#if __ARM_FEATURE_UNALIGNED
+    } else {
+      word_t *dw = __builtin_assume_aligned(d, 4);
+      const uword_t *sw = (const uword_t *)s;
+
+      for (; n >= 4; n -= 4)
+        *dw++ = *sw++;
+
+      d = (unsigned char *)dw;
+      s = (const unsigned char *)sw;
+#endif
+    }
+  }
 
-  for (i = 0; i < n; i++)
+  while (n--)
     *d++ = *s++;
+}
+
+LIBC_MEM void *memcpy(void *dest, const void *src, size_t n)
+{
+  _copy_fwd(dest, src, n);
 
   return dest;
 }
 
-void *memset(void *p, int v, size_t s)
+LIBC_MEM void *memset(void *p, int v, size_t s)
 {
   unsigned char *c = p;
-  size_t i;
 
-  for (i = 0; i < s; i++)
+  if (s >= 8) {
+    word_t *w, wv = (unsigned char)v * ONES;
+
+    while ((unsigned int)c & WORD_MASK) {
+      *c++ = (unsigned char)v;
+      s--;
+    }
+
+    w = __builtin_assume_aligned(c, 4);
+
+    for (; s >= 16; s -= 16) {
+      w[0] = wv;
+      w[1] = wv;
+      w[2] = wv;
+      w[3] = wv;
+      w += 4;
+    }
+
+    for (; s >= 4; s -= 4)
+      *w++ = wv;
+
+    c = (unsigned char *)w;
+  }
+
+  while (s--)
     *c++ = (unsigned char)v;
 
   return p;
@@ -613,14 +723,41 @@ void *calloc(size_t nmemb, size_t size)
   return p;
 }
 
-void *memmove(void *dest, const void *src, size_t n)
+LIBC_MEM void *memmove(void *dest, const void *src, size_t n)
 {
-  unsigned int i;
   unsigned char *d = dest;
   const unsigned char *s = src;
 
-  for (i = 0; i < n; i++)
-    *d++ = *s++;
+  if (d <= s || d >= s + n) {
+    _copy_fwd(d, s, n);
+    return dest;
+  }
+
+  /* overlapping with dest above src, copy backwards */
+  d += n;
+  s += n;
+
+  if (n >= 8 && (((unsigned int)d ^ (unsigned int)s) & WORD_MASK) == 0) {
+    word_t *dw;
+    const word_t *sw;
+
+    while ((unsigned int)d & WORD_MASK) {
+      *--d = *--s;
+      n--;
+    }
+
+    dw = __builtin_assume_aligned(d, 4);
+    sw = __builtin_assume_aligned(s, 4);
+
+    for (; n >= 4; n -= 4)
+      *--dw = *--sw;
+
+    d = (unsigned char *)dw;
+    s = (const unsigned char *)sw;
+  }
+
+  while (n--)
+    *--d = *--s;
 
   return dest;
 }
@@ -43,17 +43,69 @@ struct _malloc_hdr_t {
 
 #define DEBUG 0
 
+/* small blocks of up to BIN_UNITS units, header included, are kept on
+   exact size lists, they go back to the main list for coalescing only
+   when nothing on it fits */
+#ifndef CONFIG_MALLOC_BIN_UNITS
+#define BIN_UNITS 16
+#else
+#define BIN_UNITS CONFIG_MALLOC_BIN_UNITS
+#endif
+
+#ifndef CONFIG_MALLOC_STATS
+#define CONFIG_MALLOC_STATS DEBUG
+#endif
+
+/* bmos locks sbrk when the scheduler starts, allocating after that panics */
+#ifndef CONFIG_BMOS_NO_HEAP_AFTER_BOOT
+#define CONFIG_BMOS_NO_HEAP_AFTER_BOOT 0
+#endif
+
+#if CONFIG_BMOS_NO_HEAP_AFTER_BOOT
+#include "hal_common.h"
+#include "xassert.h"
+#endif
+
+#if CONFIG_MALLOC_STATS
+#include "hal_time.h"
+
+typedef struct {
+  unsigned int count;
+  unsigned int tot_us;
+  unsigned int max_us;
+} malloc_op_stats_t;
+#endif
+
 typedef struct {
   malloc_hdr_t *free_list;
-#if DEBUG
+  malloc_hdr_t *bins[BIN_UNITS + 1];
+#if CONFIG_MALLOC_STATS
   unsigned int sbrk_count;
   unsigned int count;
   unsigned int free_count;
+  unsigned int bin_hits;
+  unsigned int bin_drains;
+  unsigned int scan_max;
+  unsigned int realloc_in_place;
+  malloc_op_stats_t op_malloc;
+  malloc_op_stats_t op_free;
 #endif
 } malloc_data_t;
 
 static malloc_data_t malloc_data;
 
+#if CONFIG_MALLOC_STATS
+static void _op_stats(malloc_op_stats_t *op, hal_time_us_t start)
+{
+  unsigned int us = hal_time_us() - start;
+
+  op->count++;
+  op->tot_us += us;
+  if (us > op->max_us)
+    op->max_us = us;
+}
+#endif
+
 static void _add(malloc_hdr_t *r)
 {
   malloc_hdr_t *p, *prev = NULL;
@@ -78,31 +130,67 @@ static void _add(malloc_hdr_t *r)
     prev->next = r;
 }
 
-void *malloc(size_t nbytes)
+/* hand every binned block back to the address ordered list so it can
+   coalesce with its neighbours */
+static int _drain_bins(void)
 {
-  malloc_hdr_t *p, *next, *prev;
-  unsigned int nunits, aunits;
-
-  if (nbytes == 0)
-    return NULL;
+  malloc_hdr_t *p, *next;
+  unsigned int i;
+  int drained = 0;
+
+  for (i = 1; i <= BIN_UNITS; i++) {
+    for (p = malloc_data.bins[i]; p; p = next) {
+      next = p->next;
+      _add(p);
+      drained = 1;
+    }
+    malloc_data.bins[i] = NULL;
+  }
 
-#if DEBUG > 1
-  debug_printf("m: %p %d\n", __builtin_return_address(0), nbytes);
+#if CONFIG_MALLOC_STATS
+  if (drained)
+    malloc_data.bin_drains++;
 #endif
 
-  nunits = (nbytes + CHUNK_SIZE - 1) / CHUNK_SIZE + 1;
+  return drained;
+}
+
+/* first fit from the address ordered list, falling back to the bins and
+   then growing the heap */
+static malloc_hdr_t *_list_alloc(unsigned int nunits)
+{
+  malloc_hdr_t *p, *next, *prev;
+  unsigned int aunits;
+#if CONFIG_MALLOC_STATS
+  unsigned int scan;
+#endif
 
 restart:
   prev = NULL;
-  for (p = malloc_data.free_list; p; prev = p, p = p->next)
+#if CONFIG_MALLOC_STATS
+  scan = 0;
+#endif
+  for (p = malloc_data.free_list; p; prev = p, p = p->next) {
+#if CONFIG_MALLOC_STATS
+    scan++;
+#endif
     /* don't leave a useless one unit free */
     if (p->size > nunits + 1 || p->size == nunits)
       break;
+  }
+
+#if CONFIG_MALLOC_STATS
+  if (scan > malloc_data.scan_max)
+    malloc_data.scan_max = scan;
+#endif
 
   if (p == NULL) {
+    if (_drain_bins())
+      goto restart;
+
     aunits = ALIGN(nunits, CHUNK_POW2);
     p = sbrk(aunits * CHUNK_SIZE);
-#if DEBUG
+#if CONFIG_MALLOC_STATS
     malloc_data.sbrk_count += aunits;
 #endif
     if (p == (void *)-1)
@@ -127,8 +215,51 @@ restart:
   else
     malloc_data.free_list = next;
 
-#if DEBUG
+  return p;
+}
+
+void *malloc(size_t nbytes)
+{
+  malloc_hdr_t *p;
+  unsigned int nunits;
+#if CONFIG_MALLOC_STATS
+  hal_time_us_t start = hal_time_us();
+#endif
+
+  if (nbytes == 0)
+    return NULL;
+
+#if CONFIG_BMOS_NO_HEAP_AFTER_BOOT
+  if (sbrk_is_locked())
+    xpanic("malloc %d after boot", nbytes);
+#endif
+
+#if DEBUG > 1
+  debug_printf("m: %p %d\n", __builtin_return_address(0), nbytes);
+#endif
+
+  nunits = (nbytes + CHUNK_SIZE - 1) / CHUNK_SIZE + 1;
+
+  p = NULL;
+  if (nunits <= BIN_UNITS) {
+    p = malloc_data.bins[nunits];
+    if (p) {
+      malloc_data.bins[nunits] = p->next;
+#if CONFIG_MALLOC_STATS
+      malloc_data.bin_hits++;
+#endif
+    }
+  }
+
+  if (!p) {
+    p = _list_alloc(nunits);
+    if (!p)
+      return NULL;
+  }
+
+#if CONFIG_MALLOC_STATS
   malloc_data.count += nunits;
+  _op_stats(&malloc_data.op_malloc, start);
 #endif
 
   p->next = 0;
@@ -139,6 +270,9 @@ restart:
 void free(void *ap)
 {
   malloc_hdr_t *r;
+#if CONFIG_MALLOC_STATS
+  hal_time_us_t start = hal_time_us();
+#endif
 
 #if DEBUG > 1
   debug_printf("f: %p %p\n", __builtin_return_address(0), ap);
@@ -149,11 +283,55 @@ void free(void *ap)
 
   r = (malloc_hdr_t *)ap - 1;
 
-#if DEBUG
+#if CONFIG_MALLOC_STATS
   malloc_data.free_count += r->size;
 #endif
 
-  _add(r);
+  if (r->size <= BIN_UNITS) {
+    r->next = malloc_data.bins[r->size];
+    malloc_data.bins[r->size] = r;
+  } else
+    _add(r);
+
+#if CONFIG_MALLOC_STATS
+  _op_stats(&malloc_data.op_free, start);
+#endif
+}
+
+/* extend bp by taking the free list block that directly follows it */
+static int _grow(malloc_hdr_t *bp, unsigned int nunits)
+{
+  malloc_hdr_t *p, *prev = NULL, *end = bp + bp->size;
+  unsigned int need = nunits - bp->size;
+
+  for (p = malloc_data.free_list; p && p < end; prev = p, p = p->next)
+    ;
+
+  if (p != end || p->size < need)
+    return 0;
+
+  if (p->size > need + 1) {
+    malloc_hdr_t *next = p + need;
+
+    next->size = p->size - need;
+    next->next = p->next;
+    bp->size = nunits;
+    p = next;
+  } else {
+    bp->size += p->size;
+    p = p->next;
+  }
+
+  if (prev)
+    prev->next = p;
+  else
+    malloc_data.free_list = p;
+
+#if CONFIG_MALLOC_STATS
+  malloc_data.realloc_in_place++;
+#endif
+
+  return 1;
 }
 
 void *realloc(void *ptr, size_t size)
@@ -161,14 +339,25 @@ void *realloc(void *ptr, size_t size)
   malloc_hdr_t *bp;
   void *nptr;
   size_t sz;
+  unsigned int nunits;
 
   if (!ptr)
     return malloc(size);
 
   bp = (malloc_hdr_t*)ptr - 1;
-  sz = CHUNK_SIZE * bp->size;
+  sz = CHUNK_SIZE * (bp->size - 1);
+
+  if (sz >= size)
+    return ptr;
 
-  if (sz > size)
+#if CONFIG_BMOS_NO_HEAP_AFTER_BOOT
+  if (sbrk_is_locked())
+    xpanic("realloc %d after boot", size);
+#endif
+
+  /* binned blocks keep their size class */
+  nunits = (size + CHUNK_SIZE - 1) / CHUNK_SIZE + 1;
+  if (bp->size > BIN_UNITS && _grow(bp, nunits))
     return ptr;
 
   nptr = malloc(size);
@@ -181,26 +370,62 @@ void *realloc(void *ptr, size_t size)
   return nptr;
 }
 
-#if DEBUG
+#if CONFIG_MALLOC_STATS
+static void _op_stats_show(const char *name, malloc_op_stats_t *op)
+{
+  xprintf("%-6s %8d max(us) %4d", name, op->count, op->max_us);
+  if (op->count)
+    xprintf(" avg(ns) %d", op->tot_us * 1000 / op->count);
+  xprintf("\n");
+}
+
 static int cmd_malloc(int argc, char *argv[])
 {
   malloc_hdr_t *p;
-  unsigned int tot_free = 0;
+  unsigned int tot_free = 0, largest = 0, n_free = 0, tot_bin = 0, i;
 
-  xprintf("free list:\n");
+  if (argc > 1 && argv[1][0] == 'l')
+    xprintf("free list:\n");
 
   for (p = malloc_data.free_list; p; p = p->next) {
-    xprintf("s %p e %p next %p s %d\n", p, p + p->size, p->next, p->size);
+    if (argc > 1 && argv[1][0] == 'l')
+      xprintf("s %p e %p next %p s %d\n", p, p + p->size, p->next, p->size);
     tot_free += p->size;
+    if (p->size > largest)
+      largest = p->size;
+    n_free++;
   }
 
-  xprintf("\n");
+  xprintf("bins:");
+  for (i = 2; i <= BIN_UNITS; i++) {
+    unsigned int n = 0;
+
+    for (p = malloc_data.bins[i]; p; p = p->next)
+      n++;
+    xprintf(" %d", n);
+    tot_bin += n * i;
+  }
+  xprintf("\n\n");
+
   xprintf("count %d(%d)\n", malloc_data.count, CHUNK_SIZE * malloc_data.count);
   xprintf("sbrk  %d(%d)\n", malloc_data.sbrk_count,
           CHUNK_SIZE * malloc_data.sbrk_count);
   xprintf("freed %d(%d)\n", malloc_data.free_count,
           CHUNK_SIZE * malloc_data.free_count);
-  xprintf("free  %d(%d)\n", tot_free, CHUNK_SIZE * tot_free);
+  xprintf("free  %d(%d) in %d blocks\n", tot_free, CHUNK_SIZE * tot_free,
+          n_free);
+  xprintf("binned %d(%d)\n", tot_bin, CHUNK_SIZE * tot_bin);
+  /* share of the free list not usable by one allocation */
+  if (tot_free)
+    xprintf("frag  %d%%\n", 100 - largest * 100 / tot_free);
+
+  xprintf("\n");
+  _op_stats_show("malloc", &malloc_data.op_malloc);
+  _op_stats_show("free", &malloc_data.op_free);
+  xprintf("bin hits %d\n", malloc_data.bin_hits);
+  xprintf("bin drains %d\n", malloc_data.bin_drains);
+  xprintf("max scan %d\n", malloc_data.scan_max);
+  xprintf("realloc in place %d\n", malloc_data.realloc_in_place);
 
   xprintf("\n");
   xprintf("chunk size %d\n", CHUNK_SIZE);
@@ -208,5 +433,8 @@ static int cmd_malloc(int argc, char *argv[])
   return 0;
 }
 
-SHELL_CMD(malloc, cmd_malloc);
+SHELL_CMD_H(malloc, cmd_malloc,
+            "show heap statistics\n\n"
+            "malloc [l]: [with the free list]"
+            );
 #endif
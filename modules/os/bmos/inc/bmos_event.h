@@ -0,0 +1,47 @@
+/* Copyright (c) 2026 Brian Thomas Murphy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef BMOS_EVENT_H
+#define BMOS_EVENT_H
+
+typedef struct _bmos_event_t bmos_event_t;
+
+/* caller provided storage for event_init_static */
+typedef struct {
+  void *priv[6];
+} bmos_event_static_t;
+
+/* event_wait_ms flags */
+#define EVENT_WAIT_ANY 0x0
+#define EVENT_WAIT_ALL 0x1
+#define EVENT_CLEAR    0x2    /* clear the waited for bits on return */
+
+bmos_event_t *event_create(const char *name);
+bmos_event_t *event_init_static(bmos_event_static_t *es, const char *name);
+/* set and clear may be called from interrupt context */
+void event_set(bmos_event_t *e, unsigned int bits);
+void event_clear(bmos_event_t *e, unsigned int bits);
+unsigned int event_get(bmos_event_t *e);
+/* wait for any or all of bits, returns the matching bits or 0 on timeout */
+unsigned int event_wait_ms(bmos_event_t *e, unsigned int bits,
+                           unsigned int flags, int tms);
+
+#endif
@@ -0,0 +1,50 @@
+/* Copyright (c) 2026 Brian Thomas Murphy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef BMOS_MEMPOOL_H
+#define BMOS_MEMPOOL_H
+
+typedef struct _bmos_mempool_t bmos_mempool_t;
+
+/* caller provided storage for mempool_init_static */
+typedef struct {
+  void *priv[10];
+} bmos_mempool_static_t;
+
+/* bytes of word aligned storage needed by mempool_init_static */
+#define MEMPOOL_MEM_SIZE(_cnt_, _size_) \
+  ((_cnt_) * (((_size_) < sizeof(void *) ? sizeof(void *) : \
+               ((_size_) + 3)) & ~3))
+
+bmos_mempool_t *mempool_create(const char *name, unsigned int cnt,
+                               unsigned int size);
+bmos_mempool_t *mempool_init_static(bmos_mempool_static_t *ms,
+                                    const char *name, unsigned int cnt,
+                                    unsigned int size, void *mem);
+
+/* alloc and free may be called from interrupt context */
+void *mempool_alloc(bmos_mempool_t *mp);
+void mempool_free(bmos_mempool_t *mp, void *p);
+/* wait up to tms for a free block, tms < 0 waits forever */
+void *mempool_alloc_ms(bmos_mempool_t *mp, int tms);
+unsigned int mempool_count(bmos_mempool_t *mp);
+
+#endif
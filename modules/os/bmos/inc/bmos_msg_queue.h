@@ -35,7 +35,29 @@ bmos_msg_t *msg_wait_ms(bmos_queue_t *queue, int tms);
 
 int msg_return(bmos_msg_t *msg);
 
+/* batched variants which move up to n messages under one lock and with
+   one semaphore operation. They return the number of messages moved,
+   which is less than n when a ring queue fills up */
+
+int msg_put_n(bmos_queue_t *queue, bmos_msg_t **msgs, unsigned int n);
+
+unsigned int msg_get_n(bmos_queue_t *queue, bmos_msg_t **msgs,
+                       unsigned int n);
+
+unsigned int msg_wait_n_ms(bmos_queue_t *queue, bmos_msg_t **msgs,
+                           unsigned int n, int tms);
+
+int msg_return_n(bmos_msg_t **msgs, unsigned int n);
+
 bmos_queue_t *msg_pool_create(const char *name, int type,
                               unsigned int cnt, unsigned int size);
 
+/* bytes of word aligned storage needed by msg_pool_init_static */
+#define MSG_POOL_MEM_SIZE(_cnt_, _size_) \
+  (4 + (_cnt_) * (sizeof(bmos_msg_t) + (((_size_) + 3) & ~3)))
+
+bmos_queue_t *msg_pool_init_static(bmos_queue_static_t *qs, const char *name,
+                                   int type, unsigned int cnt,
+                                   unsigned int size, void *mem);
+
 #endif
@@ -24,7 +24,13 @@
 
 typedef struct _bmos_mutex_t bmos_mutex_t;
 
+/* caller provided storage for mutex_init_static */
+typedef struct {
+  void *priv[8];
+} bmos_mutex_static_t;
+
 bmos_mutex_t *mutex_create(const char *name);
+bmos_mutex_t *mutex_init_static(bmos_mutex_static_t *ms, const char *name);
 int mutex_lock_ms(bmos_mutex_t *s, int tms);
 void mutex_lock(bmos_mutex_t *s);
 void mutex_unlock(bmos_mutex_t *s);
@@ -46,6 +46,19 @@ bmos_op_msg_t *op_msg_wait_ms(bmos_queue_t *queue, int tms);
 
 int op_msg_return(bmos_op_msg_t *msg);
 
+/* batched variants, op and len must already be set for op_msg_put_n.
+   op_msg_wait_n_ms returns at most 8 messages per call */
+
+unsigned int op_msg_wait_n_ms(bmos_queue_t *queue, bmos_op_msg_t **msgs,
+                              unsigned int n, int tms);
+
+unsigned int op_msg_get_n(bmos_queue_t *queue, bmos_op_msg_t **msgs,
+                          unsigned int n);
+
+int op_msg_put_n(bmos_queue_t *queue, bmos_op_msg_t **msgs, unsigned int n);
+
+int op_msg_return_n(bmos_op_msg_t **msgs, unsigned int n);
+
 bmos_queue_t *op_msg_pool_create(const char *name, int type,
                                  unsigned int cnt, unsigned int size);
 
@@ -24,19 +24,45 @@
 
 #include <stdarg.h>
 
+#include "bmos_sem.h"
+
 typedef struct _bmos_queue_t bmos_queue_t;
 
+/* caller provided storage for the static queue variants */
+typedef struct {
+  void *priv[12];
+  bmos_sem_static_t sem;
+} bmos_queue_static_t;
+
 #define QUEUE_TYPE_DRIVER 0
 #define QUEUE_TYPE_TASK 1
+#define QUEUE_TYPE_RING 2
 
 bmos_queue_t *queue_create(const char *name, unsigned int type);
 
+/* single producer, single consumer ring of messages which doesn't mask
+   interrupts. size is rounded up to a power of 2. A put to a full ring
+   fails and drops the message, so producers must check the result of
+   msg_put() and msg_put_n() and keep ownership of what wasn't queued */
+bmos_queue_t *queue_ring_create(const char *name, unsigned int size);
+
+bmos_queue_t *queue_init_static(bmos_queue_static_t *qs, const char *name,
+                                unsigned int type);
+
+/* buf holds size message pointers, size must be a power of 2 */
+bmos_queue_t *queue_ring_init_static(bmos_queue_static_t *qs,
+                                     const char *name, void *buf,
+                                     unsigned int size);
+
 typedef void bmos_queue_put_f_t (void *data);
 typedef int bmos_queue_control_f_t (void *data, int control, va_list ap);
 
 int queue_set_put_f(bmos_queue_t *queue, bmos_queue_put_f_t *f,
                     bmos_queue_control_f_t *cf, void *f_data);
 
+/* serve waiting tasks in priority order - task queues only */
+int queue_set_prio_order(bmos_queue_t *queue, int en);
+
 void queue_destroy(bmos_queue_t *queue);
 
 bmos_queue_t *queue_lookup(const char *name);
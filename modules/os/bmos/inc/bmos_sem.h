@@ -24,10 +24,23 @@
 
 typedef struct _bmos_sem_t bmos_sem_t;
 
+/* caller provided storage for sem_init_static */
+typedef struct {
+  void *priv[6];
+} bmos_sem_static_t;
+
 bmos_sem_t *sem_create(const char *name, unsigned int count);
+bmos_sem_t *sem_init_static(bmos_sem_static_t *ss, const char *name,
+                            unsigned int count);
 void sem_post(bmos_sem_t *s);
 void sem_wait(bmos_sem_t *s);
 int sem_wait_ms(bmos_sem_t *s, int tms);
+void sem_post_n(bmos_sem_t *s, unsigned int n);
+/* wait for the semaphore and take up to n counts, returns the number
+   taken or 0 on timeout */
+unsigned int sem_wait_n_ms(bmos_sem_t *s, unsigned int n, int tms);
 unsigned int sem_count(bmos_sem_t *s);
+/* wake the highest priority waiter first instead of the oldest */
+void sem_set_prio_order(bmos_sem_t *s, int en);
 
 #endif
@@ -25,12 +25,26 @@
 typedef struct _bmos_task_t bmos_task_t;
 typedef void task_fun_t (void *arg);
 
+/* caller provided storage for task_init_static */
+typedef struct {
+#if CONFIG_BMOS_PROFILE
+  void *priv[40];
+#else
+  void *priv[24];
+#endif
+} bmos_task_static_t;
+
 void task_start(void);
 void task_delay(int time);
 void task_wake(bmos_task_t *t);
 bmos_task_t *task_init(task_fun_t *tf, void *ta,
                        const char *name, unsigned int prio,
                        void *stack, unsigned int stack_size);
+/* the stack must be 8 byte aligned and is required */
+bmos_task_t *task_init_static(bmos_task_static_t *ts,
+                              task_fun_t *tf, void *ta,
+                              const char *name, unsigned int prio,
+                              void *stack, unsigned int stack_size);
 
 #define TLS_IND_STDOUT 0
 
@@ -0,0 +1,55 @@
+/* Copyright (c) 2026 Brian Thomas Murphy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef BMOS_WORKQ_H
+#define BMOS_WORKQ_H
+
+#include "xtime.h"
+
+typedef struct _bmos_workq_t bmos_workq_t;
+typedef struct _bmos_work_t bmos_work_t;
+typedef void bmos_work_f_t (void *arg);
+
+/* caller owned, usually static in a driver. Only touch it through the
+   functions below once it has been submitted */
+struct _bmos_work_t {
+  bmos_work_t *next;
+  bmos_work_f_t *f;
+  void *arg;
+  xtime_ms_t due;
+  unsigned int state;
+};
+
+#define WORK_INIT(_f_, _arg_) { 0, (_f_), (_arg_), 0, 0 }
+
+void work_init(bmos_work_t *w, bmos_work_f_t *f, void *arg);
+
+/* one worker task per queue, create several for different priorities */
+bmos_workq_t *workq_create(const char *name, unsigned int prio,
+                           unsigned int stack_size);
+
+/* may be called from interrupt context. Returns 0 if the work was already
+   pending, it runs once. The work may be submitted again from its own
+   function. There is no cancel */
+int work_submit(bmos_workq_t *wq, bmos_work_t *w);
+int work_submit_delayed(bmos_workq_t *wq, bmos_work_t *w, unsigned int tms);
+
+#endif
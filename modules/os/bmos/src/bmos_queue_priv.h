@@ -24,6 +24,7 @@
 
 #include "bmos_msg_queue.h"
 #include "bmos_queue.h"
+#include "bmos_reg.h"
 #include "bmos_sem.h"
 
 typedef struct {
@@ -37,6 +38,15 @@ typedef struct {
   bmos_sem_t *sem;
 } queue_task_data_t;
 
+typedef struct {
+  bmos_sem_t *sem;
+  bmos_msg_t **buf;
+  unsigned int mask;
+  volatile unsigned int head; /* written by the producer only */
+  volatile unsigned int tail; /* written by the consumer only */
+  unsigned int drops;
+} queue_ring_data_t;
+
 typedef struct {
   unsigned short cnt;
   unsigned short size;
@@ -52,7 +62,9 @@ struct _bmos_queue_t {
   union {
     queue_driver_data_t driver;
     queue_task_data_t task;
+    queue_ring_data_t ring;
   } type_data;
+  bmos_reg_link_t reg;
 };
 
 #endif
@@ -22,14 +22,32 @@
 #ifndef BMOS_REG_H
 #define BMOS_REG_H
 
+#include <stddef.h>
+
 typedef enum {
   BMOS_REG_TYPE_TASK,
   BMOS_REG_TYPE_QUEUE,
   BMOS_REG_TYPE_SEM,
   BMOS_REG_TYPE_MUT,
+  BMOS_REG_TYPE_EVENT,
+  BMOS_REG_TYPE_MEMPOOL,
+  BMOS_REG_TYPE_WORKQ,
   BMOS_REG_TYPE_COUNT
 } bmos_reg_type_t;
 
-void bmos_reg(bmos_reg_type_t type, void *p);
+/* registry link embedded as 'reg' in every registered object */
+typedef struct _bmos_reg_link_t bmos_reg_link_t;
+
+struct _bmos_reg_link_t {
+  bmos_reg_link_t *next;
+};
+
+#define BMOS_REG_OBJ(_link_, _type_) \
+  ((_type_ *)((char *)(_link_) - offsetof(_type_, reg)))
+
+void bmos_reg(bmos_reg_type_t type, bmos_reg_link_t *link);
+
+/* kernel object allocation, fails once the heap is closed at boot */
+void *_bmos_calloc(unsigned int size);
 
 #endif
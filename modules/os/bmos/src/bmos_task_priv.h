@@ -22,25 +22,69 @@
 #ifndef BMOS_TASK_PRIV_H
 #define BMOS_TASK_PRIV_H
 
+#include "bmos_event.h"
+#include "bmos_mempool.h"
+#include "bmos_mutex.h"
+#include "bmos_reg.h"
+#include "bmos_sem.h"
 #include "bmos_task.h"
+#include "bmos_workq.h"
+#include "xtime.h"
 
 #define POISON_VAL 0x5aa5f00f
 
 #define MAX_TASK_TLS 2
 
+/* number of priority levels - limited by the width of the ready bitmap */
+#define BMOS_N_PRIO 32
+
 #define TASK_STATUS_INVALID 1
 #define TASK_STATUS_OK 0
 #define TASK_STATUS_TIMEOUT -1
 
+typedef struct _bmos_task_list_t bmos_task_list_t;
+
+#ifndef CONFIG_BMOS_PROFILE
+#define CONFIG_BMOS_PROFILE 0
+#endif
+
+/* wakeup latency buckets: <2us, <4us ... >=128us */
+#define BMOS_PROF_N_HIST 8
+
+/* load is per mille, the 10 s and 60 s averages are scaled by
+   BMOS_PROF_SCALE */
+#define BMOS_PROF_SCALE 16
+
+typedef struct {
+  unsigned int start; /* profiler time the task was switched in */
+  unsigned int ready; /* profiler time the task was woken */
+  unsigned int window; /* time run in the current 1 s window */
+  unsigned int load1;
+  unsigned int load10;
+  unsigned int load60;
+  unsigned int count_vol; /* switched out because it blocked */
+  unsigned int count_invol; /* switched out while still runnable */
+  unsigned int hist[BMOS_PROF_N_HIST];
+  unsigned char woken;
+  unsigned char pad[3];
+} bmos_task_prof_t;
+
 struct _bmos_task_t {
   void *sp;
-  unsigned char prio;
+  unsigned char prio; /* effective priority including inheritance */
   unsigned char state;
   signed char status;
-  unsigned char pad0[1];
-  int sleep;
+  unsigned char base_prio;
+  xtime_ms_t wake;
   bmos_task_t *next;
   bmos_task_t *next_waiter;
+  bmos_task_list_t *wait_list; /* waiter list the task is sleeping on */
+  bmos_mutex_t *wait_mutex; /* mutex the task is waiting for */
+  bmos_mutex_t *held; /* mutexes owned by the task */
+  bmos_task_t *rq_next;
+  bmos_task_t *rq_prev;
+  bmos_task_t *tm_next;
+  bmos_task_t *tm_prev;
 #if MAX_TASK_TLS
   void *tls[MAX_TASK_TLS];
 #endif
@@ -49,17 +93,56 @@ struct _bmos_task_t {
   unsigned int stack_size;
   unsigned int start;
   unsigned int time;
+  bmos_reg_link_t reg;
+#if CONFIG_BMOS_PROFILE
+  bmos_task_prof_t prof;
+#endif
 };
 
-typedef struct {
+struct _bmos_task_list_t {
   bmos_task_t *first;
   bmos_task_t *last;
-} bmos_task_list_t;
+  unsigned char by_prio; /* ordered by priority instead of fifo */
+  unsigned char pad[3];
+};
 
 struct _bmos_sem_t {
   bmos_task_list_t waiters;
   unsigned int count;
   const char *name;
+  bmos_reg_link_t reg;
+};
+
+struct _bmos_event_t {
+  bmos_task_list_t waiters;
+  unsigned int flags;
+  const char *name;
+  bmos_reg_link_t reg;
+};
+
+struct _bmos_mempool_t {
+  bmos_task_list_t waiters;
+  void *free;
+  char *mem;
+  const char *name;
+  unsigned short size;
+  unsigned short cnt;
+  unsigned short count;
+  unsigned short min_count; /* low water mark of free blocks */
+  unsigned int fails;
+  bmos_reg_link_t reg;
+};
+
+struct _bmos_workq_t {
+  bmos_work_t *pending; /* lifo, pushed lock free by submitters */
+  bmos_work_t *delayed; /* worker only, sorted by due time */
+  bmos_sem_t *sem;
+  bmos_task_t *task;
+  const char *name;
+  unsigned int prio;
+  unsigned int count_run;
+  unsigned int max_batch;
+  bmos_reg_link_t reg;
 };
 
 struct _bmos_mutex_t {
@@ -67,6 +150,8 @@ struct _bmos_mutex_t {
   unsigned int count;
   const char *name;
   bmos_task_t *owner;
+  bmos_mutex_t *next_held;
+  bmos_reg_link_t reg;
 };
 
 char task_state_to_char(unsigned int state);
@@ -76,16 +161,28 @@ typedef struct {
   unsigned int max;
   unsigned int count_switch;
   unsigned int count_sched;
+  unsigned int tick_tot;
+  unsigned int tick_max;
+  unsigned int count_tick;
+  unsigned int count_timeout;
+  unsigned int idle_tot;
+  unsigned int count_wakeup;
+  unsigned int count_suppressed;
 } sched_info_t;
 
 extern sched_info_t sched_info;
 
+void _task_prof_reset(void);
+
 #include "bmos_task.h"
 
 typedef struct {
   bmos_task_t *task_list;
   bmos_task_t *current;
   bmos_task_t *next;
+  bmos_task_t *timer_list;
+  unsigned int ready_map;
+  bmos_task_t *ready[BMOS_N_PRIO];
 } sched_data_t;
 
 extern sched_data_t sched_data;
@@ -93,9 +190,14 @@ extern sched_data_t sched_data;
 #define CURRENT sched_data.current
 #define NEXT sched_data.next
 #define TASK_LIST sched_data.task_list
+#define TIMER_LIST sched_data.timer_list
+#define READY_MAP sched_data.ready_map
+#define READY sched_data.ready
 
 void schedule(void);
 
+void _task_set_prio(bmos_task_t *t, unsigned int prio);
+
 void _waiters_add(bmos_task_list_t *waiters, bmos_task_t *t, int tms);
 void _waiters_remove(bmos_task_list_t *waiters, bmos_task_t *c);
 void _waiters_wake_first(bmos_task_list_t *waiters);
@@ -0,0 +1,168 @@
+/* Copyright (c) 2026 Brian Thomas Murphy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+
+#include "bmos_event.h"
+#include "bmos_reg.h"
+#include "bmos_task_priv.h"
+#include "fast_log.h"
+#include "hal_int_cpu.h"
+#include "xassert.h"
+#include "xtime.h"
+
+_Static_assert(sizeof(bmos_event_t) <= sizeof(bmos_event_static_t),
+               "bmos_event_static_t too small");
+
+static bmos_event_t *_event_init(bmos_event_t *e, const char *name)
+{
+  e->flags = 0;
+  e->name = name;
+  e->waiters.first = 0;
+  e->waiters.last = 0;
+  e->waiters.by_prio = 1;
+
+  bmos_reg(BMOS_REG_TYPE_EVENT, &e->reg);
+
+  return e;
+}
+
+bmos_event_t *event_create(const char *name)
+{
+  bmos_event_t *e = _bmos_calloc(sizeof(bmos_event_t));
+
+  if (!e)
+    return NULL;
+
+  return _event_init(e, name);
+}
+
+bmos_event_t *event_init_static(bmos_event_static_t *es, const char *name)
+{
+  return _event_init((bmos_event_t *)es, name);
+}
+
+void event_set(bmos_event_t *e, unsigned int bits)
+{
+  unsigned int saved;
+
+  FAST_LOG('E', "event_set '%s' %08x\n", e->name, bits);
+
+  INTERRUPT_ASSERT_CEILING();
+
+  saved = interrupt_disable();
+
+  e->flags |= bits;
+
+  /* every waiter rechecks its own condition */
+  while (e->waiters.first)
+    _waiters_wake_first(&e->waiters);
+
+  interrupt_enable(saved);
+}
+
+void event_clear(bmos_event_t *e, unsigned int bits)
+{
+  unsigned int saved;
+
+  INTERRUPT_ASSERT_CEILING();
+
+  saved = interrupt_disable();
+
+  e->flags &= ~bits;
+
+  interrupt_enable(saved);
+}
+
+unsigned int event_get(bmos_event_t *e)
+{
+  return e->flags;
+}
+
+/* must be called with interrupts disabled */
+static unsigned int _event_match(bmos_event_t *e, unsigned int bits,
+                                 unsigned int flags)
+{
+  unsigned int match = e->flags & bits;
+
+  if ((flags & EVENT_WAIT_ALL) && match != bits)
+    return 0;
+
+  if (match && (flags & EVENT_CLEAR))
+    e->flags &= ~match;
+
+  return match;
+}
+
+unsigned int event_wait_ms(bmos_event_t *e, unsigned int bits,
+                           unsigned int flags, int tms)
+{
+  unsigned int saved, match;
+  xtime_ms_t end = 0;
+  int status = TASK_STATUS_OK;
+
+  XASSERT(bits != 0);
+
+  FAST_LOG('E', "event_waitS '%s' %08x\n", e->name, bits);
+
+  if (tms > 0)
+    end = xtime_ms() + tms;
+
+  saved = interrupt_disable();
+
+  for (;;) {
+    match = _event_match(e, bits, flags);
+    if (match || tms == 0)
+      break;
+
+    /* spurious wakeups must not extend the timeout */
+    if (tms > 0) {
+      tms = xtime_diff_ms(end, xtime_ms());
+      if (tms <= 0)
+        break;
+    }
+
+    _waiters_add(&e->waiters, CURRENT, tms);
+
+    schedule();
+
+    interrupt_enable(saved);
+
+    __ISB();
+    __DSB();
+    asm volatile ("" : : : "memory");
+
+    saved = interrupt_disable();
+
+    status = CURRENT->status;
+    if (status == TASK_STATUS_TIMEOUT) {
+      _waiters_remove(&e->waiters, CURRENT);
+      match = _event_match(e, bits, flags);
+      break;
+    }
+  }
+
+  interrupt_enable(saved);
+
+  FAST_LOG('E', "event_waitE '%s' %08x\n", e->name, match);
+
+  return match;
+}
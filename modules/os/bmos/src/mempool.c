@@ -0,0 +1,215 @@
+/* Copyright (c) 2026 Brian Thomas Murphy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "bmos_mempool.h"
+#include "bmos_reg.h"
+#include "bmos_task_priv.h"
+#include "common.h"
+#include "fast_log.h"
+#include "hal_int_cpu.h"
+#include "xassert.h"
+#include "xtime.h"
+
+_Static_assert(sizeof(bmos_mempool_t) <= sizeof(bmos_mempool_static_t),
+               "bmos_mempool_static_t too small");
+
+static bmos_mempool_t *_mempool_init(bmos_mempool_t *mp, const char *name,
+                                     unsigned int cnt, unsigned int size,
+                                     void *mem)
+{
+  unsigned int i;
+  void **b;
+
+  XASSERT(cnt > 0 && cnt <= 0xffff && size <= 0xffff);
+
+  mp->name = name;
+  mp->mem = mem;
+  mp->size = size;
+  mp->cnt = cnt;
+  mp->count = cnt;
+  mp->min_count = cnt;
+  mp->fails = 0;
+  mp->waiters.first = 0;
+  mp->waiters.last = 0;
+  mp->waiters.by_prio = 1;
+
+  /* thread the free list through the blocks */
+  mp->free = NULL;
+  for (i = cnt; i > 0; i--) {
+    b = (void **)(mp->mem + (i - 1) * size);
+    *b = mp->free;
+    mp->free = b;
+  }
+
+  bmos_reg(BMOS_REG_TYPE_MEMPOOL, &mp->reg);
+
+  return mp;
+}
+
+static unsigned int _mempool_size(unsigned int size)
+{
+  if (size < sizeof(void *))
+    size = sizeof(void *);
+
+  return ALIGN(size, 2);
+}
+
+bmos_mempool_t *mempool_create(const char *name, unsigned int cnt,
+                               unsigned int size)
+{
+  bmos_mempool_t *mp;
+  void *mem;
+
+  size = _mempool_size(size);
+
+  mp = _bmos_calloc(sizeof(bmos_mempool_t));
+  if (!mp)
+    return NULL;
+
+  mem = _bmos_calloc(cnt * size);
+  if (!mem) {
+    free(mp);
+    return NULL;
+  }
+
+  return _mempool_init(mp, name, cnt, size, mem);
+}
+
+bmos_mempool_t *mempool_init_static(bmos_mempool_static_t *ms,
+                                    const char *name, unsigned int cnt,
+                                    unsigned int size, void *mem)
+{
+  return _mempool_init((bmos_mempool_t *)ms, name, cnt,
+                       _mempool_size(size), mem);
+}
+
+/* must be called with interrupts disabled */
+static void *_mempool_get(bmos_mempool_t *mp)
+{
+  void **b = mp->free;
+
+  if (!b)
+    return NULL;
+
+  mp->free = *b;
+  mp->count--;
+  if (mp->count < mp->min_count)
+    mp->min_count = mp->count;
+
+  return b;
+}
+
+void *mempool_alloc(bmos_mempool_t *mp)
+{
+  unsigned int saved;
+  void *p;
+
+  INTERRUPT_ASSERT_CEILING();
+
+  saved = interrupt_disable();
+
+  p = _mempool_get(mp);
+  if (!p)
+    mp->fails++;
+
+  interrupt_enable(saved);
+
+  return p;
+}
+
+void *mempool_alloc_ms(bmos_mempool_t *mp, int tms)
+{
+  unsigned int saved;
+  int status = TASK_STATUS_OK;
+  xtime_ms_t end = 0;
+  void *p;
+
+  if (tms > 0)
+    end = xtime_ms() + tms;
+
+  saved = interrupt_disable();
+
+  while (!(p = _mempool_get(mp)) && tms != 0 &&
+         status != TASK_STATUS_TIMEOUT) {
+    /* losing a freed block to another allocator must not extend the
+       timeout */
+    if (tms > 0) {
+      tms = xtime_diff_ms(end, xtime_ms());
+      if (tms <= 0)
+        break;
+    }
+
+    _waiters_add(&mp->waiters, CURRENT, tms);
+
+    schedule();
+
+    interrupt_enable(saved);
+
+    __ISB();
+    __DSB();
+    asm volatile ("" : : : "memory");
+
+    saved = interrupt_disable();
+
+    status = CURRENT->status;
+  }
+
+  if (!p) {
+    if (status == TASK_STATUS_TIMEOUT)
+      _waiters_remove(&mp->waiters, CURRENT);
+    mp->fails++;
+  }
+
+  interrupt_enable(saved);
+
+  FAST_LOG('P', "mempool_alloc '%s' %p\n", mp->name, p);
+
+  return p;
+}
+
+void mempool_free(bmos_mempool_t *mp, void *p)
+{
+  unsigned int saved;
+  void **b = p;
+
+  XASSERT((char *)p >= mp->mem && (char *)p < mp->mem + mp->cnt * mp->size);
+  XASSERT(((char *)p - mp->mem) % mp->size == 0);
+
+  INTERRUPT_ASSERT_CEILING();
+
+  saved = interrupt_disable();
+
+  *b = mp->free;
+  mp->free = b;
+  mp->count++;
+
+  _waiters_wake_first(&mp->waiters);
+
+  interrupt_enable(saved);
+}
+
+unsigned int mempool_count(bmos_mempool_t *mp)
+{
+  return mp->count;
+}
@@ -20,6 +20,7 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "bmos_reg.h"
 #include "bmos_mutex.h"
@@ -27,31 +28,107 @@
 #include "hal_int_cpu.h"
 #include "xassert.h"
 
+_Static_assert(sizeof(bmos_mutex_t) <= sizeof(bmos_mutex_static_t),
+               "bmos_mutex_static_t too small");
+
+static bmos_mutex_t *_mutex_init(bmos_mutex_t *m, const char *name)
+{
+  m->name = name;
+  m->waiters.by_prio = 1;
+
+  bmos_reg(BMOS_REG_TYPE_MUT, &m->reg);
+
+  return m;
+}
+
 bmos_mutex_t *mutex_create(const char *name)
 {
-  bmos_mutex_t *m = calloc(1, sizeof(bmos_mutex_t));
+  bmos_mutex_t *m = _bmos_calloc(sizeof(bmos_mutex_t));
 
   if (!m)
     return NULL;
 
-  m->name = name;
+  return _mutex_init(m, name);
+}
 
-  bmos_reg(BMOS_REG_TYPE_MUT, (void *)m);
+bmos_mutex_t *mutex_init_static(bmos_mutex_static_t *ms, const char *name)
+{
+  memset(ms, 0, sizeof(bmos_mutex_t));
 
-  return m;
+  return _mutex_init((bmos_mutex_t *)ms, name);
+}
+
+/* priority a task should run at - its own or the highest priority of the
+   tasks waiting for the mutexes it owns */
+static unsigned int _mutex_task_prio(bmos_task_t *t)
+{
+  unsigned int prio = t->base_prio;
+  bmos_mutex_t *m;
+
+  for (m = t->held; m; m = m->next_held) {
+    /* waiters are ordered by priority */
+    bmos_task_t *w = m->waiters.first;
+
+    if (w && w->prio > prio)
+      prio = w->prio;
+  }
+
+  return prio;
+}
+
+/* recalculate the priority of a task and pass the change along the chain
+   of mutex owners it is waiting for */
+static void _mutex_update_prio(bmos_task_t *t)
+{
+  unsigned int prio;
+
+  while (t) {
+    prio = _mutex_task_prio(t);
+    if (prio == t->prio)
+      break;
+
+    _task_set_prio(t, prio);
+
+    t = t->wait_mutex ? t->wait_mutex->owner : NULL;
+  }
+}
+
+static void _mutex_held_remove(bmos_task_t *t, bmos_mutex_t *m)
+{
+  bmos_mutex_t **p;
+
+  for (p = &t->held; *p; p = &(*p)->next_held)
+    if (*p == m) {
+      *p = m->next_held;
+      break;
+    }
+
+  m->next_held = NULL;
 }
 
 void mutex_unlock(bmos_mutex_t *m)
 {
-  unsigned int saved;
+  unsigned int saved, prio;
+  bmos_task_t *t;
 
   saved = interrupt_disable();
 
-  XASSERT(m->count > 0 && m->owner == CURRENT);
+  t = CURRENT;
+
+  XASSERT(m->count > 0 && m->owner == t);
 
   if (--m->count == 0) {
     m->owner = NULL;
-    _waiters_wake_first(&m->waiters);
+    _mutex_held_remove(t, m);
+
+    /* drop any priority inherited through this mutex */
+    prio = t->prio;
+    _mutex_update_prio(t);
+
+    if (m->waiters.first)
+      _waiters_wake_first(&m->waiters);
+    else if (t->prio != prio)
+      schedule();
   }
 
   interrupt_enable(saved);
@@ -75,6 +152,12 @@ int mutex_lock_ms(bmos_mutex_t *m, int tms)
   while (m->count > 0 && status != TASK_STATUS_TIMEOUT) {
     _waiters_add(&m->waiters, t, tms);
 
+    if (tms != 0) {
+      /* let the owner inherit our priority */
+      t->wait_mutex = m;
+      _mutex_update_prio(m->owner);
+    }
+
     schedule();
 
     interrupt_enable(saved);
@@ -89,13 +172,22 @@ int mutex_lock_ms(bmos_mutex_t *m, int tms)
 
   XASSERT(status == TASK_STATUS_TIMEOUT || status == TASK_STATUS_OK);
 
-  if (status == TASK_STATUS_TIMEOUT)
-    _waiters_remove(&m->waiters, CURRENT);
-  else {
+  t->wait_mutex = NULL;
+
+  if (status == TASK_STATUS_TIMEOUT) {
+    _waiters_remove(&m->waiters, t);
+    /* the owner may no longer need the inherited priority */
+    _mutex_update_prio(m->owner);
+  } else {
     XASSERT(m->owner == NULL && m->count == 0);
 
-    m->owner = CURRENT;
+    m->owner = t;
     m->count++;
+    m->next_held = t->held;
+    t->held = m;
+
+    /* inherit from the tasks still waiting */
+    _mutex_update_prio(t);
   }
 
 exit:
@@ -110,4 +202,3 @@ void mutex_lock(bmos_mutex_t *m)
 
   XASSERT(status == TASK_STATUS_OK);
 }
-
@@ -66,6 +66,65 @@ int op_msg_return(bmos_op_msg_t *msg)
   return msg_return(m);
 }
 
+/* the batched calls convert through a bounded local array so larger
+   requests are split into chunks of OP_MSG_BATCH */
+#define OP_MSG_BATCH 8
+
+unsigned int op_msg_wait_n_ms(bmos_queue_t *queue, bmos_op_msg_t **msgs,
+                              unsigned int n, int tms)
+{
+  bmos_msg_t *m[OP_MSG_BATCH];
+  unsigned int i, count;
+
+  if (n > OP_MSG_BATCH)
+    n = OP_MSG_BATCH;
+
+  count = msg_wait_n_ms(queue, m, n, tms);
+
+  for (i = 0; i < count; i++)
+    msgs[i] = (bmos_op_msg_t *)BMOS_MSG_GET_DATA(m[i]);
+
+  return count;
+}
+
+unsigned int op_msg_get_n(bmos_queue_t *queue, bmos_op_msg_t **msgs,
+                          unsigned int n)
+{
+  return op_msg_wait_n_ms(queue, msgs, n, 0);
+}
+
+int op_msg_put_n(bmos_queue_t *queue, bmos_op_msg_t **msgs, unsigned int n)
+{
+  bmos_msg_t *m[OP_MSG_BATCH];
+  unsigned int i, j;
+  int count = 0;
+
+  for (i = 0; i < n; i += j) {
+    for (j = 0; j < OP_MSG_BATCH && i + j < n; j++)
+      m[j] = BMOS_MSG_GET_MSG(msgs[i + j]);
+
+    count += msg_put_n(queue, m, j);
+  }
+
+  return count;
+}
+
+int op_msg_return_n(bmos_op_msg_t **msgs, unsigned int n)
+{
+  bmos_msg_t *m[OP_MSG_BATCH];
+  unsigned int i, j;
+  int count = 0;
+
+  for (i = 0; i < n; i += j) {
+    for (j = 0; j < OP_MSG_BATCH && i + j < n; j++)
+      m[j] = BMOS_MSG_GET_MSG(msgs[i + j]);
+
+    count += msg_return_n(m, j);
+  }
+
+  return count;
+}
+
 bmos_queue_t *op_msg_pool_create(const char *name, int type,
                                  unsigned int cnt, unsigned int size)
 {
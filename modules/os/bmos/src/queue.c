@@ -30,35 +30,118 @@
 #include "common.h"
 #include "hal_int.h"
 #include "xassert.h"
+#include "xtime.h"
 
 #include "fast_log.h"
 
+_Static_assert(sizeof(bmos_queue_t) <=
+               sizeof(((bmos_queue_static_t *)0)->priv),
+               "bmos_queue_static_t too small");
+
+static bmos_queue_t *_queue_init(bmos_queue_t *q, const char *name,
+                                 unsigned int type, bmos_sem_t *sem)
+{
+  q->name = name;
+  q->type = type;
+
+  if (type == QUEUE_TYPE_TASK)
+    q->type_data.task.sem = sem;
+  else if (type == QUEUE_TYPE_RING)
+    q->type_data.ring.sem = sem;
+
+  bmos_reg(BMOS_REG_TYPE_QUEUE, &q->reg);
+
+  return q;
+}
+
 bmos_queue_t *queue_create(const char *name, unsigned int type)
 {
   bmos_queue_t *q;
+  bmos_sem_t *sem = NULL;
 
   if (type > QUEUE_TYPE_TASK)
     return NULL;
 
-  q = calloc(1, sizeof(bmos_queue_t));
+  q = _bmos_calloc(sizeof(bmos_queue_t));
   if (!q)
     return NULL;
 
-  q->name = name;
-  q->type = type;
-
   if (type == QUEUE_TYPE_TASK) {
-    bmos_sem_t *sem = sem_create(name, 0);
+    sem = sem_create(name, 0);
     if (!sem) {
       free(q);
       return NULL;
     }
-    q->type_data.task.sem = sem;
   }
 
-  bmos_reg(BMOS_REG_TYPE_QUEUE, (void *)q);
+  return _queue_init(q, name, type, sem);
+}
 
-  return q;
+bmos_queue_t *queue_init_static(bmos_queue_static_t *qs, const char *name,
+                                unsigned int type)
+{
+  bmos_sem_t *sem = NULL;
+
+  if (type > QUEUE_TYPE_TASK)
+    return NULL;
+
+  memset(qs->priv, 0, sizeof(qs->priv));
+
+  if (type == QUEUE_TYPE_TASK)
+    sem = sem_init_static(&qs->sem, name, 0);
+
+  return _queue_init((bmos_queue_t *)qs->priv, name, type, sem);
+}
+
+bmos_queue_t *queue_ring_create(const char *name, unsigned int size)
+{
+  bmos_queue_t *q;
+  queue_ring_data_t *r;
+  bmos_sem_t *sem;
+  unsigned int n;
+
+  for (n = 1; n < size; n <<= 1)
+    ;
+
+  q = _bmos_calloc(sizeof(bmos_queue_t));
+  if (!q)
+    return NULL;
+
+  r = &q->type_data.ring;
+
+  r->buf = _bmos_calloc(n * sizeof(bmos_msg_t *));
+  if (!r->buf) {
+    free(q);
+    return NULL;
+  }
+
+  sem = sem_create(name, 0);
+  if (!sem) {
+    free(r->buf);
+    free(q);
+    return NULL;
+  }
+
+  r->mask = n - 1;
+
+  return _queue_init(q, name, QUEUE_TYPE_RING, sem);
+}
+
+bmos_queue_t *queue_ring_init_static(bmos_queue_static_t *qs,
+                                     const char *name, void *buf,
+                                     unsigned int size)
+{
+  bmos_queue_t *q = (bmos_queue_t *)qs->priv;
+
+  XASSERT(size > 0 && (size & (size - 1)) == 0);
+
+  memset(qs->priv, 0, sizeof(qs->priv));
+
+  q->type_data.ring.buf = buf;
+  q->type_data.ring.mask = size - 1;
+
+  return _queue_init(q, name, QUEUE_TYPE_RING,
+                     sem_init_static(&qs->sem, name, 0));
 }
 
 void queue_destroy(bmos_queue_t *queue)
@@ -155,14 +238,132 @@ static int msg_put_driver(bmos_queue_t *queue, bmos_msg_t *msg)
   return 0;
 }
 
+/* ring queues are only ever written by a single producer and read by a
+   single consumer so no lock is needed. The barriers order the slot write
+   against the index update and the index update against the check for an
+   empty ring so a consumer going to sleep never misses a wakeup. A full
+   ring drops the message and returns -1, the caller still owns it. */
+static int msg_put_ring(bmos_queue_t *queue, bmos_msg_t *msg)
+{
+  queue_ring_data_t *r = &queue->type_data.ring;
+  unsigned int head = r->head;
+
+  if (head - r->tail > r->mask) {
+    r->drops++;
+    return -1;
+  }
+
+  msg->next = NULL;
+  msg->queue = queue;
+
+  r->buf[head & r->mask] = msg;
+  __DMB();
+  r->head = head + 1;
+  __DMB();
+
+  /* only wake the consumer on the empty to non empty transition */
+  if (r->tail == head)
+    sem_post(r->sem);
+
+  return 0;
+}
+
 int msg_put(bmos_queue_t *queue, bmos_msg_t *msg)
 {
+  int r;
+
+  INTERRUPT_ASSERT_CEILING();
+
   XASSERT(msg->queue == NULL);
 
   if (queue->type == QUEUE_TYPE_TASK)
-    return msg_put_task(queue, msg);
+    r = msg_put_task(queue, msg);
+  else if (queue->type == QUEUE_TYPE_RING)
+    r = msg_put_ring(queue, msg);
+  else     /* QUEUE_TYPE_DRIVER */
+    r = msg_put_driver(queue, msg);
+
+  FAST_TRACE(FAST_TRACE_QUEUE, queue->name, queue_get_count(queue));
+
+  return r;
+}
+
+static int msg_put_n_task(bmos_queue_t *queue, bmos_msg_t **msgs,
+                          unsigned int n)
+{
+  unsigned int saved, i;
+
+  saved = interrupt_disable();
+  for (i = 0; i < n; i++)
+    _put(queue, msgs[i]);
+  interrupt_enable(saved);
+
+  sem_post_n(queue->type_data.task.sem, n);
+
+  return n;
+}
+
+static int msg_put_n_driver(bmos_queue_t *queue, bmos_msg_t **msgs,
+                            unsigned int n)
+{
+  unsigned int saved, i;
+  bmos_queue_put_f_t *f;
+  void *f_data;
+
+  FAST_LOG('Q', "put_n %s %d\n", queue->name, n);
+
+  saved = interrupt_disable();
+
+  queue->type_data.driver.count += n;
+  for (i = 0; i < n; i++)
+    _put(queue, msgs[i]);
+
+  f = queue->type_data.driver.put_f;
+  f_data = queue->type_data.driver.put_f_data;
+
+  interrupt_enable(saved);
+
+  if (f)
+    f(f_data);
+
+  return n;
+}
+
+static int msg_put_n_ring(bmos_queue_t *queue, bmos_msg_t **msgs,
+                          unsigned int n)
+{
+  unsigned int i;
+
+  for (i = 0; i < n; i++)
+    if (msg_put_ring(queue, msgs[i]) < 0)
+      break;
+
+  return i;
+}
+
+int msg_put_n(bmos_queue_t *queue, bmos_msg_t **msgs, unsigned int n)
+{
+  unsigned int i;
+  int r;
+
+  INTERRUPT_ASSERT_CEILING();
+
+  for (i = 0; i < n; i++)
+    XASSERT(msgs[i]->queue == NULL);
+
+  if (n == 0)
+    return 0;
+
+  if (queue->type == QUEUE_TYPE_TASK)
+    r = msg_put_n_task(queue, msgs, n);
+  else if (queue->type == QUEUE_TYPE_RING)
+    r = msg_put_n_ring(queue, msgs, n);
   else     /* QUEUE_TYPE_DRIVER */
-    return msg_put_driver(queue, msg);
+    r = msg_put_n_driver(queue, msgs, n);
+
+  FAST_TRACE(FAST_TRACE_QUEUE, queue->name, queue_get_count(queue));
+
+  return r;
 }
 
 static bmos_msg_t *msg_wait_ms_task(bmos_queue_t *queue, int tms)
@@ -202,12 +403,151 @@ static bmos_msg_t *msg_wait_ms_driver(bmos_queue_t *queue, int tms)
   return msg;
 }
 
+static bmos_msg_t *_get_ring(bmos_queue_t *queue)
+{
+  queue_ring_data_t *r = &queue->type_data.ring;
+  unsigned int tail = r->tail;
+  bmos_msg_t *msg;
+
+  if (tail == r->head)
+    return NULL;
+
+  __DMB();
+  msg = r->buf[tail & r->mask];
+  __DMB();
+  r->tail = tail + 1;
+  __DMB();
+
+  msg->queue = NULL;
+
+  return msg;
+}
+
+static bmos_msg_t *msg_wait_ms_ring(bmos_queue_t *queue, int tms)
+{
+  bmos_msg_t *msg;
+  xtime_ms_t end = 0;
+
+  if (tms > 0)
+    end = xtime_ms() + tms;
+
+  /* the semaphore may hold a stale wakeup for a message which was already
+     taken, so recheck the ring after each wakeup without extending the
+     timeout */
+  while (!(msg = _get_ring(queue))) {
+    if (tms > 0) {
+      tms = xtime_diff_ms(end, xtime_ms());
+      if (tms <= 0)
+        break;
+    }
+
+    if (tms == 0 || sem_wait_ms(queue->type_data.ring.sem, tms) != 0)
+      break;
+  }
+
+  return msg;
+}
+
 bmos_msg_t *msg_wait_ms(bmos_queue_t *queue, int tms)
 {
+  bmos_msg_t *r;
+
+  INTERRUPT_ASSERT_CEILING();
+
+  if (queue->type == QUEUE_TYPE_TASK)
+    r = msg_wait_ms_task(queue, tms);
+  else if (queue->type == QUEUE_TYPE_RING)
+    r = msg_wait_ms_ring(queue, tms);
+  else     /* QUEUE_TYPE_DRIVER */
+    r = msg_wait_ms_driver(queue, tms);
+
+  FAST_TRACE(FAST_TRACE_QUEUE, queue->name, queue_get_count(queue));
+
+  return r;
+}
+
+static unsigned int msg_wait_n_ms_task(bmos_queue_t *queue, bmos_msg_t **msgs,
+                                       unsigned int n, int tms)
+{
+  unsigned int saved, count, i;
+
+  count = sem_wait_n_ms(queue->type_data.task.sem, n, tms);
+  if (count == 0)
+    return 0;
+
+  saved = interrupt_disable();
+  for (i = 0; i < count; i++)
+    msgs[i] = _get(queue);
+  interrupt_enable(saved);
+
+  return count;
+}
+
+static unsigned int msg_wait_n_ms_driver(bmos_queue_t *queue,
+                                         bmos_msg_t **msgs, unsigned int n)
+{
+  unsigned int saved, count;
+
+  saved = interrupt_disable();
+
+  count = queue->type_data.driver.count;
+  if (count > n)
+    count = n;
+
+  queue->type_data.driver.count -= count;
+  for (n = 0; n < count; n++)
+    msgs[n] = _get(queue);
+
+  FAST_LOG('Q', "get_n %s %d\n", queue->name, count);
+
+  interrupt_enable(saved);
+
+  return count;
+}
+
+static unsigned int msg_wait_n_ms_ring(bmos_queue_t *queue, bmos_msg_t **msgs,
+                                       unsigned int n, int tms)
+{
+  unsigned int count;
+
+  msgs[0] = msg_wait_ms_ring(queue, tms);
+  if (!msgs[0])
+    return 0;
+
+  for (count = 1; count < n; count++) {
+    msgs[count] = _get_ring(queue);
+    if (!msgs[count])
+      break;
+  }
+
+  return count;
+}
+
+unsigned int msg_wait_n_ms(bmos_queue_t *queue, bmos_msg_t **msgs,
+                           unsigned int n, int tms)
+{
+  unsigned int r;
+
+  INTERRUPT_ASSERT_CEILING();
+
+  if (n == 0)
+    return 0;
+
   if (queue->type == QUEUE_TYPE_TASK)
-    return msg_wait_ms_task(queue, tms);
+    r = msg_wait_n_ms_task(queue, msgs, n, tms);
+  else if (queue->type == QUEUE_TYPE_RING)
+    r = msg_wait_n_ms_ring(queue, msgs, n, tms);
   else     /* QUEUE_TYPE_DRIVER */
-    return msg_wait_ms_driver(queue, tms);
+    r = msg_wait_n_ms_driver(queue, msgs, n);
+
+  FAST_TRACE(FAST_TRACE_QUEUE, queue->name, queue_get_count(queue));
+
+  return r;
+}
+
+unsigned int msg_get_n(bmos_queue_t *queue, bmos_msg_t **msgs, unsigned int n)
+{
+  return msg_wait_n_ms(queue, msgs, n, 0);
 }
 
 bmos_msg_t *msg_get(bmos_queue_t *queue)
@@ -225,40 +565,83 @@ int msg_return(bmos_msg_t *msg)
   return msg_put(msg->home, msg);
 }
 
+int msg_return_n(bmos_msg_t **msgs, unsigned int n)
+{
+  unsigned int i, j;
+  int count = 0;
+
+  /* put runs of messages with the same home in one go */
+  for (i = 0; i < n; i = j) {
+    for (j = i + 1; j < n; j++)
+      if (msgs[j]->home != msgs[i]->home)
+        break;
+
+    count += msg_put_n(msgs[i]->home, msgs + i, j - i);
+  }
+
+  return count;
+}
+
+_Static_assert(sizeof(bmos_pool_data_t) == 4, "MSG_POOL_MEM_SIZE mismatch");
+
+static void _msg_pool_init(bmos_queue_t *q, bmos_pool_data_t *p,
+                           unsigned int cnt, unsigned int size)
+{
+  unsigned int i, asize;
+  bmos_msg_t *m;
+
+  asize = sizeof(bmos_msg_t) + size;
+
+  q->pool_data = p;
+
+  p->cnt = cnt;
+  p->size = size;
+
+  m = (bmos_msg_t *)(p + 1);
+
+  for (i = 0; i < cnt; i++) {
+    msg_init(m, q, size);
+    msg_put(q, m);
+
+    m = (bmos_msg_t *)((char *)m + asize);
+  }
+}
+
 bmos_queue_t *msg_pool_create(const char *name, int type,
                               unsigned int cnt, unsigned int size)
 {
   bmos_queue_t *q;
-  unsigned int i, asize;
   bmos_pool_data_t *p;
-  bmos_msg_t *m;
 
   q = queue_create(name, type);
   if (!q)
     return NULL;
 
   size = ALIGN(size, 2); /* round up to to multiple of 4 */
-  asize = sizeof(bmos_msg_t) + size;
 
-  p = malloc(sizeof(bmos_pool_data_t) + cnt * asize);
+  p = _bmos_calloc(sizeof(bmos_pool_data_t) +
+                   cnt * (sizeof(bmos_msg_t) + size));
   if (!p) {
     queue_destroy(q);
     return NULL;
   }
 
-  q->pool_data = p;
+  _msg_pool_init(q, p, cnt, size);
 
-  p->cnt = cnt;
-  p->size = size;
+  return q;
+}
 
-  m = (bmos_msg_t *)(p + 1);
+bmos_queue_t *msg_pool_init_static(bmos_queue_static_t *qs, const char *name,
+                                   int type, unsigned int cnt,
+                                   unsigned int size, void *mem)
+{
+  bmos_queue_t *q;
 
-  for (i = 0; i < cnt; i++) {
-    msg_init(m, q, size);
-    msg_put(q, m);
+  q = queue_init_static(qs, name, type);
+  if (!q)
+    return NULL;
 
-    m = (bmos_msg_t *)((char *)m + asize);
-  }
+  _msg_pool_init(q, (bmos_pool_data_t *)mem, cnt, ALIGN(size, 2));
 
   return q;
 }
@@ -289,6 +672,16 @@ int queue_set_put_f(bmos_queue_t *queue, bmos_queue_put_f_t *f,
   return 0;
 }
 
+int queue_set_prio_order(bmos_queue_t *queue, int en)
+{
+  if (queue->type != QUEUE_TYPE_TASK)
+    return -1;
+
+  sem_set_prio_order(queue->type_data.task.sem, en);
+
+  return 0;
+}
+
 const char * queue_get_name(bmos_queue_t *queue)
 {
   return queue->name;
@@ -310,12 +703,21 @@ static unsigned int queue_count_driver(bmos_queue_t *queue)
   return count;
 }
 
+static unsigned int queue_count_ring(bmos_queue_t *queue)
+{
+  queue_ring_data_t *r = &queue->type_data.ring;
+
+  return r->head - r->tail;
+}
+
 unsigned int queue_get_count(bmos_queue_t *queue)
 {
   unsigned int count;
 
   if (queue->type == QUEUE_TYPE_TASK)
     count = queue_count_task(queue);
+  else if (queue->type == QUEUE_TYPE_RING)
+    count = queue_count_ring(queue);
   else     /* QUEUE_TYPE_DRIVER */
     count = queue_count_driver(queue);
 
@@ -29,6 +29,8 @@
 #include "bmos_queue_priv.h"
 #include "bmos_sem.h"
 #include "bmos_mutex.h"
+#include "bmos_event.h"
+#include "bmos_mempool.h"
 #include "bmos_msg.h"
 #include "hal_int.h"
 #include "xassert.h"
@@ -36,13 +38,11 @@
 #include "shell.h"
 #include "io.h"
 
-#define BMOS_REG_CHUNK 4
 #define MAX_WAITERS 8
 
 typedef struct {
-  void **list;
-  unsigned short count;
-  unsigned short alloc;
+  bmos_reg_link_t *first;
+  bmos_reg_link_t *last;
 } reg_t;
 
 static reg_t reg_list[BMOS_REG_TYPE_COUNT];
@@ -61,23 +61,28 @@ static void bmos_reg_printf(int debug, const char *fmt, ...)
   va_end(ap);
 }
 
-void bmos_reg(bmos_reg_type_t type, void *p)
+void bmos_reg(bmos_reg_type_t type, bmos_reg_link_t *link)
 {
+  unsigned int saved;
   reg_t *r;
 
   if (type >= BMOS_REG_TYPE_COUNT)
     xpanic("invalid registration type %d", type);
 
   r = &reg_list[type];
-  if (r->alloc == r->count) {
-    r->alloc += BMOS_REG_CHUNK;
 
-    r->list = realloc(r->list, r->alloc * sizeof(void *));
-    XASSERT(r->list);
-  }
+  link->next = NULL;
+
+  /* append to keep the listings in creation order */
+  saved = interrupt_disable();
 
-  r->list[r->count] = p;
-  r->count++;
+  if (r->last)
+    r->last->next = link;
+  else
+    r->first = link;
+  r->last = link;
+
+  interrupt_enable(saved);
 }
 
 #if CONFIG_POISON_STACK
@@ -101,11 +106,11 @@ static unsigned int task_check_stack_used(bmos_task_t *t)
 void task_info(char opt, int debug)
 {
   reg_t *r = &reg_list[BMOS_REG_TYPE_TASK];
-  unsigned int i;
+  bmos_reg_link_t *l;
 
   if (opt == 'r') {
-    for (i = 0; i < r->count; i++) {
-      bmos_task_t *t = (bmos_task_t *)r->list[i];
+    for (l = r->first; l; l = l->next) {
+      bmos_task_t *t = BMOS_REG_OBJ(l, bmos_task_t);
       t->time = 0;
     }
     return;
@@ -117,8 +122,8 @@ void task_info(char opt, int debug)
 #endif
   bmos_reg_printf(debug, " prio\n");
 
-  for (i = 0; i < r->count; i++) {
-    bmos_task_t *t = (bmos_task_t *)r->list[i];
+  for (l = r->first; l; l = l->next) {
+    bmos_task_t *t = BMOS_REG_OBJ(l, bmos_task_t);
 
 #if CONFIG_POISON_STACK
     unsigned int stack_used;
@@ -144,25 +149,33 @@ void task_info(char opt, int debug)
 void queue_info(char opt, int debug)
 {
   reg_t *r = &reg_list[BMOS_REG_TYPE_QUEUE];
-  unsigned int i;
+  bmos_reg_link_t *l;
 
   bmos_reg_printf(debug, "name       typ count\n");
 
-  for (i = 0; i < r->count; i++) {
-    bmos_queue_t *q = (bmos_queue_t *)r->list[i];
+  for (l = r->first; l; l = l->next) {
+    bmos_queue_t *q = BMOS_REG_OBJ(l, bmos_queue_t);
     char type;
     unsigned int count;
 
     if (q->type == QUEUE_TYPE_TASK) {
       type = 't';
       count = q->type_data.task.sem->count;
+    } else if (q->type == QUEUE_TYPE_RING) {
+      type = 'r';
+      count = queue_get_count(q);
     } else {
       type = 'd';
       count = q->type_data.driver.count;
     }
 
-    bmos_reg_printf(debug, "%-10s %c   %5d %s\n", q->name, type, count,
-                    q->pool_data ? "pool" : "");
+    if (q->type == QUEUE_TYPE_RING)
+      bmos_reg_printf(debug, "%-10s %c   %5d size %d drop %d\n", q->name, type,
+                      count, q->type_data.ring.mask + 1,
+                      q->type_data.ring.drops);
+    else
+      bmos_reg_printf(debug, "%-10s %c   %5d %s\n", q->name, type, count,
+                      q->pool_data ? "pool" : "");
 
     if (opt == 'd') {
 #define N_MSGS 32
@@ -193,15 +206,34 @@ void queue_info(char opt, int debug)
   }
 }
 
+static void show_waiters(bmos_task_list_t *wait_list, int debug)
+{
+  unsigned int saved, count, i;
+  bmos_task_t *waiters[MAX_WAITERS], *t;
+
+  saved = interrupt_disable();
+
+  for (count = 0, t = wait_list->first;
+       count < MAX_WAITERS && t;
+       count++, t = t->next_waiter)
+    waiters[count] = t;
+
+  interrupt_enable(saved);
+
+  if (count > 0)
+    for (i = 0; i < count; i++)
+      bmos_reg_printf(debug, "  %s\n", waiters[i]->name);
+}
+
 void pool_info(char opt, int debug)
 {
   reg_t *r = &reg_list[BMOS_REG_TYPE_QUEUE];
-  unsigned int i;
+  bmos_reg_link_t *l;
 
   bmos_reg_printf(debug, "name       typ count alloc size\n");
 
-  for (i = 0; i < r->count; i++) {
-    bmos_queue_t *q = (bmos_queue_t *)r->list[i];
+  for (l = r->first; l; l = l->next) {
+    bmos_queue_t *q = BMOS_REG_OBJ(l, bmos_queue_t);
     char type;
     unsigned int count;
 
@@ -234,38 +266,33 @@ void pool_info(char opt, int debug)
       }
     }
   }
-}
 
-static void show_waiters(bmos_task_list_t *wait_list, int debug)
-{
-  unsigned int saved, count, i;
-  bmos_task_t *waiters[MAX_WAITERS], *t;
+  r = &reg_list[BMOS_REG_TYPE_MEMPOOL];
 
-  saved = interrupt_disable();
-
-  for (count = 0, t = wait_list->first;
-       count < MAX_WAITERS && t;
-       count++, t = t->next_waiter)
-    waiters[count] = t;
+  for (l = r->first; l; l = l->next) {
+    bmos_mempool_t *mp = BMOS_REG_OBJ(l, bmos_mempool_t);
 
-  interrupt_enable(saved);
+    bmos_reg_printf(debug, "%-10s m   %5d %5d %4d max %d fail %d\n",
+                    mp->name, mp->count, mp->cnt, mp->size,
+                    mp->cnt - mp->min_count, mp->fails);
 
-  if (count > 0)
-    for (i = 0; i < count; i++)
-      bmos_reg_printf(debug, "  %s\n", waiters[i]->name);
+    if (opt == 'd')
+      show_waiters(&mp->waiters, debug);
+  }
 }
 
 void sem_info(char opt, int debug)
 {
   reg_t *r = &reg_list[BMOS_REG_TYPE_SEM];
-  unsigned int i;
+  bmos_reg_link_t *l;
 
-  bmos_reg_printf(debug, "name       count\n");
+  bmos_reg_printf(debug, "name       count ord\n");
 
-  for (i = 0; i < r->count; i++) {
-    bmos_sem_t *s = (bmos_sem_t *)r->list[i];
+  for (l = r->first; l; l = l->next) {
+    bmos_sem_t *s = BMOS_REG_OBJ(l, bmos_sem_t);
 
-    bmos_reg_printf(debug, "%-10s %d\n", s->name, s->count);
+    bmos_reg_printf(debug, "%-10s %5d %c\n", s->name, s->count,
+                    s->waiters.by_prio ? 'p' : 'f');
 
     if (opt == 'd')
       show_waiters(&s->waiters, debug);
@@ -275,22 +302,108 @@ void sem_info(char opt, int debug)
 void mutex_info(char opt, int debug)
 {
   reg_t *r = &reg_list[BMOS_REG_TYPE_MUT];
-  unsigned int i;
+  bmos_reg_link_t *l;
 
-  bmos_reg_printf(debug, "name       count owner\n");
+  bmos_reg_printf(debug, "name       count owner      prio base\n");
 
-  for (i = 0; i < r->count; i++) {
-    bmos_mutex_t *m = (bmos_mutex_t *)r->list[i];
+  for (l = r->first; l; l = l->next) {
+    bmos_mutex_t *m = BMOS_REG_OBJ(l, bmos_mutex_t);
     bmos_task_t *t = m->owner;
 
-    bmos_reg_printf(debug, "%-10s %5d %s\n", m->name, m->count,
-                    t ? t->name : "");
+    if (t)
+      bmos_reg_printf(debug, "%-10s %5d %-10s %4d %4d\n", m->name, m->count,
+                      t->name, t->prio, t->base_prio);
+    else
+      bmos_reg_printf(debug, "%-10s %5d\n", m->name, m->count);
 
     if (opt == 'd')
       show_waiters(&m->waiters, debug);
   }
 }
 
+void event_info(char opt, int debug)
+{
+  reg_t *r = &reg_list[BMOS_REG_TYPE_EVENT];
+  bmos_reg_link_t *l;
+
+  bmos_reg_printf(debug, "name       flags\n");
+
+  for (l = r->first; l; l = l->next) {
+    bmos_event_t *e = BMOS_REG_OBJ(l, bmos_event_t);
+
+    bmos_reg_printf(debug, "%-10s %08x\n", e->name, e->flags);
+
+    if (opt == 'd')
+      show_waiters(&e->waiters, debug);
+  }
+}
+
+void workq_info(char opt, int debug)
+{
+  reg_t *r = &reg_list[BMOS_REG_TYPE_WORKQ];
+  bmos_reg_link_t *l;
+
+  bmos_reg_printf(debug, "name       pri      run batch delayed\n");
+
+  for (l = r->first; l; l = l->next) {
+    bmos_workq_t *wq = BMOS_REG_OBJ(l, bmos_workq_t);
+    unsigned int saved, delayed = 0;
+    bmos_work_t *w;
+
+    /* the worker changes the list from task context, keep it off the cpu */
+    saved = interrupt_disable();
+    for (w = wq->delayed; w; w = w->next)
+      delayed++;
+    interrupt_enable(saved);
+
+    bmos_reg_printf(debug, "%-10s %3d %8d %5d %7d\n", wq->name, wq->prio,
+                    wq->count_run, wq->max_batch, delayed);
+  }
+}
+
+#if CONFIG_BMOS_PROFILE
+/* 'm' gives one key=value line per task for scripts, loads are per mille */
+void prof_info(char opt, int debug)
+{
+  reg_t *r = &reg_list[BMOS_REG_TYPE_TASK];
+  bmos_reg_link_t *l;
+  unsigned int i;
+
+  if (opt == 'r') {
+    _task_prof_reset();
+    return;
+  }
+
+  if (opt != 'm')
+    bmos_reg_printf(debug, "name       load%%  10s%%  60s%%      vol    invol"
+                    "  lat(us) <2 <4 <8 <16 <32 <64 <128 >=128\n");
+
+  for (l = r->first; l; l = l->next) {
+    bmos_task_t *t = BMOS_REG_OBJ(l, bmos_task_t);
+    bmos_task_prof_t p = t->prof;
+    unsigned int l10 = p.load10 / BMOS_PROF_SCALE;
+    unsigned int l60 = p.load60 / BMOS_PROF_SCALE;
+
+    if (opt == 'm') {
+      bmos_reg_printf(debug, "task=%s prio=%d load1=%d load10=%d load60=%d "
+                      "vol=%d invol=%d lat=", t->name, t->prio, p.load1,
+                      l10, l60, p.count_vol, p.count_invol);
+      for (i = 0; i < BMOS_PROF_N_HIST; i++)
+        bmos_reg_printf(debug, i ? ",%d" : "%d", p.hist[i]);
+      bmos_reg_printf(debug, "\n");
+      continue;
+    }
+
+    bmos_reg_printf(debug, "%-10s %3d.%d %3d.%d %3d.%d %8d %8d         ",
+                    t->name, p.load1 / 10, p.load1 % 10, l10 / 10, l10 % 10,
+                    l60 / 10, l60 % 10, p.count_vol, p.count_invol);
+    for (i = 0; i < BMOS_PROF_N_HIST; i++)
+      bmos_reg_printf(debug, " %d", p.hist[i]);
+    bmos_reg_printf(debug, "\n");
+  }
+}
+#endif
+
 void show_sched_info(char opt)
 {
   if (opt == 'r') {
@@ -306,6 +419,17 @@ void show_sched_info(char opt)
     unsigned int ns = (sched_info.tot * 1000) / sched_info.count_sched;
     xprintf("avg(ns) %u\n", ns);
   }
+  xprintf("tick max(us) %u\n", sched_info.tick_max);
+  xprintf("tick tot(us) %u\n", sched_info.tick_tot);
+  xprintf("tick    %u\n", sched_info.count_tick);
+  xprintf("timeout %u\n", sched_info.count_timeout);
+  if (sched_info.count_tick > 0) {
+    unsigned int ns = (sched_info.tick_tot * 1000) / sched_info.count_tick;
+    xprintf("tick avg(ns) %u\n", ns);
+  }
+  xprintf("idle(us) %u\n", sched_info.idle_tot);
+  xprintf("wakeup  %u\n", sched_info.count_wakeup);
+  xprintf("no tick %u\n", sched_info.count_suppressed);
 }
 
 int cmd_os(int argc, char *argv[])
@@ -326,6 +450,17 @@ int cmd_os(int argc, char *argv[])
   case 'm':
     mutex_info(argv[1][1], 0);
     break;
+  case 'e':
+    event_info(argv[1][1], 0);
+    break;
+  case 'w':
+    workq_info(argv[1][1], 0);
+    break;
+#if CONFIG_BMOS_PROFILE
+  case 'l':
+    prof_info(argv[1][1], 0);
+    break;
+#endif
   default:
   case 't':
     task_info(argv[1][1], 0);
@@ -338,12 +473,21 @@ int cmd_os(int argc, char *argv[])
   return 0;
 }
 
+#if CONFIG_BMOS_PROFILE
+#define OS_HELP_PROF "os l[m|r]: task load and latency [machine|reset]\n"
+#else
+#define OS_HELP_PROF ""
+#endif
+
 SHELL_CMD_H(os, cmd_os,
             "display os information\n\n"
             "os q[d]: queue [details]\n"
             "os p[d]: pool [details]\n"
             "os s[d]: semaphore [details]\n"
             "os m[d]: mutex [details]\n"
+            "os e[d]: event [details]\n"
+            "os w: work queues\n"
             "os t: task\n"
+            OS_HELP_PROF
             "os h: scheduling statistics"
             );
@@ -28,23 +28,58 @@
 #include "hal_int_cpu.h"
 #include "xassert.h"
 
-bmos_sem_t *sem_create(const char *name, unsigned int count)
-{
-  bmos_sem_t *s = malloc(sizeof(bmos_sem_t));
+/* wake waiters in priority order instead of fifo by default */
+#ifndef CONFIG_BMOS_WAITERS_BY_PRIO
+#define CONFIG_BMOS_WAITERS_BY_PRIO 0
+#endif
 
-  if (!s)
-    return NULL;
+_Static_assert(sizeof(bmos_sem_t) <= sizeof(bmos_sem_static_t),
+               "bmos_sem_static_t too small");
 
+static bmos_sem_t *_sem_init(bmos_sem_t *s, const char *name,
+                             unsigned int count)
+{
   s->count = count;
   s->name = name;
   s->waiters.first = 0;
   s->waiters.last = 0;
+  s->waiters.by_prio = CONFIG_BMOS_WAITERS_BY_PRIO;
 
-  bmos_reg(BMOS_REG_TYPE_SEM, (void *)s);
+  bmos_reg(BMOS_REG_TYPE_SEM, &s->reg);
 
   return s;
 }
 
+bmos_sem_t *sem_create(const char *name, unsigned int count)
+{
+  bmos_sem_t *s = _bmos_calloc(sizeof(bmos_sem_t));
+
+  if (!s)
+    return NULL;
+
+  return _sem_init(s, name, count);
+}
+
+bmos_sem_t *sem_init_static(bmos_sem_static_t *ss, const char *name,
+                            unsigned int count)
+{
+  return _sem_init((bmos_sem_t *)ss, name, count);
+}
+
+void sem_set_prio_order(bmos_sem_t *s, int en)
+{
+  unsigned int saved;
+
+  saved = interrupt_disable();
+
+  /* only change the order of an empty list */
+  XASSERT(s->waiters.first == NULL);
+
+  s->waiters.by_prio = en ? 1 : 0;
+
+  interrupt_enable(saved);
+}
+
 unsigned int sem_count(bmos_sem_t *s)
 {
   unsigned int saved, count;
@@ -64,15 +99,37 @@ void sem_post(bmos_sem_t *s)
 
   FAST_LOG('S', "sem_post '%s'\n", s->name, 0);
 
+  INTERRUPT_ASSERT_CEILING();
+
   saved = interrupt_disable();
 
   s->count++;
+  FAST_TRACE(FAST_TRACE_SEM, s->name, s->count);
 
   _waiters_wake_first(&s->waiters);
 
   interrupt_enable(saved);
 }
 
+void sem_post_n(bmos_sem_t *s, unsigned int n)
+{
+  unsigned int saved;
+
+  FAST_LOG('S', "sem_post_n '%s' %d\n", s->name, n);
+
+  INTERRUPT_ASSERT_CEILING();
+
+  saved = interrupt_disable();
+
+  s->count += n;
+  FAST_TRACE(FAST_TRACE_SEM, s->name, s->count);
+
+  while (n-- > 0 && s->waiters.first)
+    _waiters_wake_first(&s->waiters);
+
+  interrupt_enable(saved);
+}
+
 void sem_wait(bmos_sem_t *s)
 {
   (void)sem_wait_ms(s, -1);
@@ -85,6 +142,8 @@ int sem_wait_ms(bmos_sem_t *s, int tms)
 
   FAST_LOG('S', "sem_wait_msS '%s' %d\n", s->name, tms);
 
+  INTERRUPT_ASSERT_CEILING();
+
   saved = interrupt_disable();
 
   if (tms == 0) {
@@ -124,9 +183,31 @@ int sem_wait_ms(bmos_sem_t *s, int tms)
   }
 
 exit:
+  FAST_TRACE(FAST_TRACE_SEM, s->name, s->count);
   interrupt_enable(saved);
 
   FAST_LOG('S', "sem_wait_msE '%s' %d\n", s->name, status);
 
   return status;
 }
+
+unsigned int sem_wait_n_ms(bmos_sem_t *s, unsigned int n, int tms)
+{
+  unsigned int saved, count;
+
+  if (n == 0 || sem_wait_ms(s, tms) != TASK_STATUS_OK)
+    return 0;
+
+  /* take whatever else is available without waiting */
+  saved = interrupt_disable();
+
+  count = s->count;
+  if (count > n - 1)
+    count = n - 1;
+  s->count -= count;
+  FAST_TRACE(FAST_TRACE_SEM, s->name, s->count);
+
+  interrupt_enable(saved);
+
+  return count + 1;
+}
@@ -28,6 +28,8 @@
 #include "common.h"
 #include "cortexm.h"
 #include "fast_log.h"
+#include "hal_board.h"
+#include "hal_common.h"
 #include "hal_int.h"
 #include "hal_time.h"
 #include "io.h"
@@ -37,6 +39,33 @@
 
 volatile xtime_ms_t systick_count = 0;
 
+#ifndef CONFIG_BMOS_TICKLESS
+#define CONFIG_BMOS_TICKLESS 0
+#endif
+
+/* panic on any heap allocation once the scheduler has started, for the
+   libc_min malloc, otherwise only kernel allocations and sbrk growth */
+#ifndef CONFIG_BMOS_NO_HEAP_AFTER_BOOT
+#define CONFIG_BMOS_NO_HEAP_AFTER_BOOT 0
+#endif
+
+#if CONFIG_BMOS_TICKLESS && CONFIG_TIMER_16BIT
+#error tickless idle needs a 32 bit time base
+#endif
+
+#if CONFIG_BMOS_PROFILE
+/* armv6-m has no cycle counter, fall back to the microsecond timer */
+#if __ARM_ARCH_6M__
+#define PROF_NOW() hal_time_us()
+#define PROF_PER_US 1
+#else
+#define PROF_NOW() cycle_cnt()
+#define PROF_PER_US (hal_cpu_clock / 1000000)
+#endif
+
+static xtime_ms_t prof_last;
+#endif
+
 #define TASK_STATE_EXIT 0
 #define TASK_STATE_RUN 1
 #define TASK_STATE_SLEEP 2
@@ -50,23 +79,194 @@ static inline void _task_yield()
 
 sched_data_t sched_data = { 0 };
 
+/* ready queue: one circular list per priority level plus a bitmap of the
+   levels which have at least one runnable task */
+static void _ready_add(bmos_task_t *t)
+{
+  bmos_task_t *h = READY[t->prio];
+
+  if (!h) {
+    t->rq_next = t;
+    t->rq_prev = t;
+    READY[t->prio] = t;
+    READY_MAP |= BIT(t->prio);
+  } else {
+    /* add at the tail */
+    t->rq_next = h;
+    t->rq_prev = h->rq_prev;
+    h->rq_prev->rq_next = t;
+    h->rq_prev = t;
+  }
+}
+
+static void _ready_remove(bmos_task_t *t)
+{
+  if (t->rq_next == t) {
+    READY[t->prio] = NULL;
+    READY_MAP &= ~BIT(t->prio);
+  } else {
+    t->rq_prev->rq_next = t->rq_next;
+    t->rq_next->rq_prev = t->rq_prev;
+    if (READY[t->prio] == t)
+      READY[t->prio] = t->rq_next;
+  }
+  t->rq_next = NULL;
+  t->rq_prev = NULL;
+}
+
+/* timer list: sleeping tasks with a timeout sorted by absolute wakeup time
+   so the tick handler only has to look at the head */
+static void _timer_add(bmos_task_t *t, xtime_ms_t wake)
+{
+  bmos_task_t *n, *p = NULL;
+
+  t->wake = wake;
+
+  for (n = TIMER_LIST; n; p = n, n = n->tm_next)
+    if (xtime_diff_ms(wake, n->wake) < 0)
+      break;
+
+  t->tm_next = n;
+  t->tm_prev = p;
+  if (n)
+    n->tm_prev = t;
+  if (p)
+    p->tm_next = t;
+  else
+    TIMER_LIST = t;
+}
+
+static void _timer_remove(bmos_task_t *t)
+{
+  if (t->tm_prev)
+    t->tm_prev->tm_next = t->tm_next;
+  else if (TIMER_LIST == t)
+    TIMER_LIST = t->tm_next;
+  else
+    return; /* not on the timer list */
+
+  if (t->tm_next)
+    t->tm_next->tm_prev = t->tm_prev;
+
+  t->tm_next = NULL;
+  t->tm_prev = NULL;
+}
+
+/* must be called with interrupts disabled */
+static void _task_set_state(bmos_task_t *t, unsigned int state)
+{
+  if (t->state == state)
+    return;
+
+  if (t->state == TASK_STATE_RUN)
+    _ready_remove(t);
+  else if (state == TASK_STATE_RUN)
+    _ready_add(t);
+
+  if (t->state == TASK_STATE_SLEEP) {
+    _timer_remove(t);
+    if (t->wait_list)
+      _waiters_remove(t->wait_list, t);
+#if CONFIG_BMOS_PROFILE
+    t->prof.ready = PROF_NOW();
+    t->prof.woken = 1;
+#endif
+  }
+
+  t->state = state;
+}
+
+/* sleep for tms milliseconds, tms < 0 sleeps until woken */
+static void _task_sleep(bmos_task_t *t, int tms)
+{
+  _task_set_state(t, TASK_STATE_SLEEP);
+  t->status = TASK_STATUS_INVALID;
+
+  if (tms > 0)
+    _timer_add(t, systick_count + tms);
+}
+
+#if CONFIG_BMOS_TICKLESS
+/* number of ticks the idle task can sleep without missing a timeout,
+   0 when the tick must keep running */
+static unsigned int _idle_ticks(void)
+{
+  xtime_diff_ms_t diff;
+
+  /* other tasks at the idle priority need the tick for round robin */
+  if (READY_MAP != BIT(0) || CURRENT->rq_next != CURRENT)
+    return 0;
+
+  if (!TIMER_LIST)
+    return (unsigned int)-1;
+
+  diff = xtime_diff_ms(TIMER_LIST->wake, systick_count);
+  if (diff <= 1)
+    return 0;
+
+  return (unsigned int)diff;
+}
+#endif
+
 static void idle_task(void *arg)
 {
-  for (;;)
-    __WFI();
+  unsigned int saved, start;
+
+  for (;;) {
+    saved = interrupt_disable();
+
+    start = hal_time_us();
+
+#if CONFIG_BMOS_TICKLESS
+    {
+      unsigned int n = _idle_ticks();
+
+      if (n > 1) {
+        unsigned int elapsed = systick_suppress(n);
+
+        systick_count += elapsed;
+        sched_info.count_suppressed += elapsed;
+      } else
+        interrupt_wfi();
+    }
+#else
+    interrupt_wfi();
+#endif
+
+    sched_info.idle_tot += hal_time_us() - start;
+    sched_info.count_wakeup++;
+
+    /* pending interrupts are taken here */
+    interrupt_enable(saved);
+  }
 }
 
 void task_start(void)
 {
+  static bmos_task_static_t idle_tcb;
+  static unsigned long long idle_stack[128 / 8];
   bmos_task_t *t;
 
-  t = task_init(idle_task, NULL, "idle", 0, 0, 64);
+  t = task_init_static(&idle_tcb, idle_task, NULL, "idle", 0,
+                       idle_stack, sizeof(idle_stack));
+
+#if CONFIG_BMOS_NO_HEAP_AFTER_BOOT
+  sbrk_lock();
+#endif
 
   set_psp((unsigned char *)t->sp + sizeof(sw_stack_frame_t));
 
   CURRENT = t;
   NEXT = t;
 
+#if CONFIG_BMOS_PROFILE
+#if !__ARM_ARCH_6M__
+  dwt_init();
+#endif
+  t->prof.start = PROF_NOW();
+  prof_last = systick_count;
+#endif
+
   _task_yield();
 
   INTERRUPT_ON();
@@ -75,8 +275,13 @@ void task_start(void)
 
 static void task_cleanup(void)
 {
-  CURRENT->state = TASK_STATE_EXIT;
+  unsigned int saved;
+
+  saved = interrupt_disable();
+  _task_set_state(CURRENT, TASK_STATE_EXIT);
   schedule();
+  interrupt_enable(saved);
+
   /* actually cleanup here - remove task from run list */
   for (;;)
     ;
@@ -102,29 +307,25 @@ static void *hw_task_init(task_fun_t *tf, void *ta, void *sp)
   return (void *)ssf;
 }
 
-bmos_task_t *task_init(task_fun_t *tf, void *ta, const char *name,
-                       unsigned int prio,
-                       void *stack, unsigned int stack_size)
+void *_bmos_calloc(unsigned int size)
 {
-  void *sp;
-  bmos_task_t *t;
+#if CONFIG_BMOS_NO_HEAP_AFTER_BOOT
+  if (CURRENT)
+    xpanic("heap use after boot");
+#endif
 
-  t = calloc(sizeof(bmos_task_t), 1);
-  if (!t) {
-    xprintf("no memory for task allocation");
-    return NULL;
-  }
+  return calloc(1, size);
+}
 
-  if (!stack) {
-    /* ensure alignment to double word */
-    stack_size = ALIGN(stack_size, 3);
+_Static_assert(sizeof(bmos_task_t) <= sizeof(bmos_task_static_t),
+               "bmos_task_static_t too small");
 
-    stack = malloc(stack_size);
-    if (!stack) {
-      xprintf("no memory for stack allocation");
-      return NULL;
-    }
-  }
+static bmos_task_t *_task_init(bmos_task_t *t, task_fun_t *tf, void *ta,
+                               const char *name, unsigned int prio,
+                               void *stack, unsigned int stack_size)
+{
+  void *sp;
+  unsigned int saved;
 
 #if CONFIG_POISON_STACK
   {
@@ -141,35 +342,65 @@ bmos_task_t *task_init(task_fun_t *tf, void *ta, const char *name,
   t->sp = sp;
   t->stack = stack;
   t->stack_size = stack_size;
-  t->state = TASK_STATE_RUN;
+  t->state = TASK_STATE_EXIT;
   t->prio = prio;
+  t->base_prio = prio;
   t->name = name;
 
-  if (TASK_LIST == NULL)
-    TASK_LIST = t;
-  else {
-    bmos_task_t *p = NULL;
-    bmos_task_t *n = TASK_LIST;
-
-    while (n) {
-      if (prio > n->prio) {
-        if (!p)
-          TASK_LIST = t;
-        else
-          p->next = t;
-        t->next = n;
-        break;
-      }
-      p = n;
-      n = n->next;
+  saved = interrupt_disable();
+
+  t->next = TASK_LIST;
+  TASK_LIST = t;
+
+  _task_set_state(t, TASK_STATE_RUN);
+
+  interrupt_enable(saved);
+
+  bmos_reg(BMOS_REG_TYPE_TASK, &t->reg);
+
+  return t;
+}
+
+bmos_task_t *task_init(task_fun_t *tf, void *ta, const char *name,
+                       unsigned int prio,
+                       void *stack, unsigned int stack_size)
+{
+  bmos_task_t *t;
+
+  XASSERT(prio < BMOS_N_PRIO);
+
+  t = _bmos_calloc(sizeof(bmos_task_t));
+  if (!t) {
+    xprintf("no memory for task allocation");
+    return NULL;
+  }
+
+  if (!stack) {
+    /* ensure alignment to double word */
+    stack_size = ALIGN(stack_size, 3);
+
+    stack = _bmos_calloc(stack_size);
+    if (!stack) {
+      xprintf("no memory for stack allocation");
+      return NULL;
     }
-    if (!n)
-      p->next = t;
   }
 
-  bmos_reg(BMOS_REG_TYPE_TASK, (void *)t);
+  return _task_init(t, tf, ta, name, prio, stack, stack_size);
+}
 
-  return t;
+bmos_task_t *task_init_static(bmos_task_static_t *ts,
+                              task_fun_t *tf, void *ta,
+                              const char *name, unsigned int prio,
+                              void *stack, unsigned int stack_size)
+{
+  XASSERT(prio < BMOS_N_PRIO);
+  XASSERT(stack);
+
+  memset(ts, 0, sizeof(bmos_task_t));
+
+  return _task_init((bmos_task_t *)ts, tf, ta, name, prio, stack,
+                    stack_size);
 }
 
 void task_delay(int time)
@@ -181,11 +412,7 @@ void task_delay(int time)
 
   saved = interrupt_disable();
 
-  if (time != 0) {
-    CURRENT->sleep = time;
-    CURRENT->state = TASK_STATE_SLEEP;
-    CURRENT->status = TASK_STATUS_INVALID;
-  }
+  _task_sleep(CURRENT, time);
 
   schedule();
 
@@ -199,7 +426,7 @@ void task_wake(bmos_task_t *t)
   saved = interrupt_disable();
 
   if (t->state == TASK_STATE_SLEEP) {
-    t->state = TASK_STATE_RUN;
+    _task_set_state(t, TASK_STATE_RUN);
     t->status = TASK_STATUS_TIMEOUT;
     schedule();
   }
@@ -211,31 +438,22 @@ sched_info_t sched_info;
 
 void schedule(void)
 {
-  bmos_task_t *t;
-  unsigned int start, diff;
+  bmos_task_t *t, *c = CURRENT;
+  unsigned int start, diff, prio;
 
   start = hal_time_us();
 
-  /* find next task */
-  t = TASK_LIST;
-  while (t) {
-    if (t->state == TASK_STATE_RUN) {
-      /* round robin of tasks at this priority level */
-      bmos_task_t *c = CURRENT;
-      if ((t->prio == c->prio) && c->next && (c->next->prio == c->prio)) {
-        c = c->next;
-        while (c && (c->prio == t->prio)) {
-          if (c->state == TASK_STATE_RUN) {
-            t = c;
-            break;
-          }
-          c = c->next;
-        }
-      }
-      break;
-    }
-    t = t->next;
-  }
+  if (!READY_MAP)
+    return;
+
+  /* highest priority level with a runnable task */
+  prio = 31 - __builtin_clz(READY_MAP);
+
+  /* round robin of tasks at this priority level */
+  if (c && c->state == TASK_STATE_RUN && c->prio == prio)
+    t = c->rq_next;
+  else
+    t = READY[prio];
 
   if (t != CURRENT) {
     NEXT = t;
@@ -256,20 +474,87 @@ static void _task_periodic(void)
 {
   bmos_task_t *t;
 
-  /* handle sleep */
-  for (t = TASK_LIST; t; t = t->next) {
-    if ((t->state == TASK_STATE_SLEEP) && (t->sleep > 0)) {
-      t->sleep--;
-      if (t->sleep == 0) {
-        t->state = TASK_STATE_RUN;
-        t->status = TASK_STATUS_TIMEOUT;
-      }
-    }
+  /* handle sleep - only the expired tasks at the head are touched */
+  while ((t = TIMER_LIST) && xtime_diff_ms(t->wake, systick_count) <= 0) {
+    _task_set_state(t, TASK_STATE_RUN);
+    t->status = TASK_STATUS_TIMEOUT;
+    sched_info.count_timeout++;
   }
 
   schedule();
 }
 
+#if CONFIG_BMOS_PROFILE
+static void _prof_switch(bmos_task_t *c, bmos_task_t *n)
+{
+  unsigned int now = PROF_NOW();
+
+  c->prof.window += now - c->prof.start;
+  n->prof.start = now;
+
+  if (c->state == TASK_STATE_RUN)
+    c->prof.count_invol++;
+  else
+    c->prof.count_vol++;
+
+  if (n->prof.woken) {
+    unsigned int us = (now - n->prof.ready) / PROF_PER_US;
+    unsigned int b = 0;
+
+    while ((us >>= 1) && b < BMOS_PROF_N_HIST - 1)
+      b++;
+
+    n->prof.hist[b]++;
+    n->prof.woken = 0;
+  }
+}
+
+/* close the 1 s load window and update the averages */
+static void _prof_window(void)
+{
+  unsigned int now = PROF_NOW(), total = 0;
+  bmos_task_t *t;
+
+  CURRENT->prof.window += now - CURRENT->prof.start;
+  CURRENT->prof.start = now;
+
+  for (t = TASK_LIST; t; t = t->next)
+    total += t->prof.window;
+
+  if (total == 0)
+    return;
+
+  for (t = TASK_LIST; t; t = t->next) {
+    unsigned int load;
+
+    load = (unsigned long long)t->prof.window * 1000 / total;
+
+    t->prof.load1 = load;
+    load *= BMOS_PROF_SCALE;
+    t->prof.load10 = t->prof.load10 - t->prof.load10 / 10 + load / 10;
+    t->prof.load60 = t->prof.load60 - t->prof.load60 / 60 + load / 60;
+    t->prof.window = 0;
+  }
+}
+
+void _task_prof_reset(void)
+{
+  unsigned int saved;
+  bmos_task_t *t;
+
+  saved = interrupt_disable();
+
+  for (t = TASK_LIST; t; t = t->next) {
+    unsigned int start = t->prof.start;
+
+    memset(&t->prof, 0, sizeof(t->prof));
+    t->prof.start = start;
+  }
+
+  interrupt_enable(saved);
+}
+#endif
+
 void *_pendsv_handler(void *sp)
 {
   unsigned int now;
@@ -281,7 +566,19 @@ void *_pendsv_handler(void *sp)
   CURRENT->time += now - CURRENT->start;
   NEXT->start = now;
 
+#if CONFIG_BMOS_PROFILE
+  {
+    /* the tick closes load windows so keep it out */
+    unsigned int saved = interrupt_disable();
+
+    _prof_switch(CURRENT, NEXT);
+
+    interrupt_enable(saved);
+  }
+#endif
+
   FAST_LOG('T', "task switch '%s' -> '%s'\n", CURRENT->name, NEXT->name);
+  FAST_TRACE(FAST_TRACE_SWITCH, CURRENT->name, NEXT->name);
 
   CURRENT = NEXT;
 
@@ -292,40 +589,79 @@ void *_pendsv_handler(void *sp)
 
 void systick_handler(void)
 {
+  unsigned int start, diff;
+
+  start = hal_time_us();
+
   systick_count++;
 
   systick_hook();
 
+#if CONFIG_BMOS_PROFILE
+  if (xtime_diff_ms(systick_count, prof_last) >= 1000) {
+    prof_last = systick_count;
+    _prof_window();
+  }
+#endif
+
   _task_periodic();
+
+  diff = hal_time_us() - start;
+
+  sched_info.tick_tot += diff;
+  if (diff > sched_info.tick_max)
+    sched_info.tick_max = diff;
+
+  sched_info.count_tick++;
 }
 
 void svc_handler(void)
 {
 }
 
-void _waiters_add(bmos_task_list_t *waiters, bmos_task_t *t, int tms)
+static void _waiters_insert(bmos_task_list_t *waiters, bmos_task_t *t)
 {
-  if (!waiters->first) {
-    waiters->first = t;
-    waiters->last = t;
+  bmos_task_t *n, *p = NULL;
+
+  if (waiters->by_prio) {
+    /* fifo within a priority level */
+    for (n = waiters->first; n; p = n, n = n->next_waiter)
+      if (t->prio > n->prio)
+        break;
   } else {
-    waiters->last->next_waiter = t;
-    waiters->last = t;
+    n = NULL;
+    p = waiters->last;
   }
-  t->next_waiter = 0;
-  if (tms == 0)
+
+  t->next_waiter = n;
+  if (p)
+    p->next_waiter = t;
+  else
+    waiters->first = t;
+  if (!n)
+    waiters->last = t;
+
+  t->wait_list = waiters;
+}
+
+void _waiters_add(bmos_task_list_t *waiters, bmos_task_t *t, int tms)
+{
+  if (tms == 0) {
     t->status = TASK_STATUS_TIMEOUT;
-  else {
-    t->state = TASK_STATE_SLEEP;
-    t->sleep = tms;
-    t->status = TASK_STATUS_INVALID;
+    return;
   }
+
+  _waiters_insert(waiters, t);
+  _task_sleep(t, tms);
 }
 
 void _waiters_remove(bmos_task_list_t *waiters, bmos_task_t *c)
 {
   bmos_task_t *t, *p = 0;
 
+  if (c->wait_list != waiters)
+    return;
+
   t = waiters->first;
 
   while (t) {
@@ -334,12 +670,16 @@ void _waiters_remove(bmos_task_list_t *waiters, bmos_task_t *c)
         p->next_waiter = t->next_waiter;
       else
         waiters->first = t->next_waiter;
+      if (waiters->last == t)
+        waiters->last = p;
       t->next_waiter = 0;
       break;
     }
     p = t;
     t = t->next_waiter;
   }
+
+  c->wait_list = NULL;
 }
 
 void _waiters_wake_first(bmos_task_list_t *waiters)
@@ -349,12 +689,33 @@ void _waiters_wake_first(bmos_task_list_t *waiters)
   t = waiters->first;
 
   if (t) {
-    if (t->state == TASK_STATE_SLEEP) {
-      waiters->first = t->next_waiter;
-      t->state = TASK_STATE_RUN;
-      t->status = TASK_STATUS_OK;
-      t->next_waiter = 0;
-      schedule();
+    /* leaving the sleep state takes the task off the waiter list */
+    _task_set_state(t, TASK_STATE_RUN);
+    t->status = TASK_STATUS_OK;
+    schedule();
+  }
+}
+
+/* must be called with interrupts disabled */
+void _task_set_prio(bmos_task_t *t, unsigned int prio)
+{
+  bmos_task_list_t *waiters;
+
+  if (t->prio == prio)
+    return;
+
+  if (t->state == TASK_STATE_RUN) {
+    _ready_remove(t);
+    t->prio = prio;
+    _ready_add(t);
+  } else {
+    t->prio = prio;
+
+    /* keep the waiter list ordered */
+    waiters = t->wait_list;
+    if (waiters && waiters->by_prio) {
+      _waiters_remove(waiters, t);
+      _waiters_insert(waiters, t);
     }
   }
 }
@@ -0,0 +1,256 @@
+/* Copyright (c) 2026 Brian Thomas Murphy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+
+#include "bmos_reg.h"
+#include "bmos_sem.h"
+#include "bmos_task_priv.h"
+#include "bmos_workq.h"
+#include "fast_log.h"
+#include "hal_int_cpu.h"
+#include "xassert.h"
+#include "xtime.h"
+
+#define WORK_IDLE 0
+#define WORK_QUEUED 1
+#define WORK_DELAYED 2
+
+#ifndef CONFIG_WORKQ_STACK_SIZE
+#define CONFIG_WORKQ_STACK_SIZE 512
+#endif
+
+/* submit is a lock free push onto a lifo, the worker takes the whole list
+   at once. armv6-m has no ldrex/strex so it masks interrupts instead */
+#if __ARM_ARCH_6M__
+static int _work_claim(bmos_work_t *w, unsigned int state)
+{
+  unsigned int saved;
+  int claimed = 0;
+
+  saved = interrupt_disable();
+  if (w->state == WORK_IDLE) {
+    w->state = state;
+    claimed = 1;
+  }
+  interrupt_enable(saved);
+
+  return claimed;
+}
+
+static bmos_work_t *_work_push(bmos_workq_t *wq, bmos_work_t *w)
+{
+  unsigned int saved;
+  bmos_work_t *old;
+
+  saved = interrupt_disable();
+  old = wq->pending;
+  w->next = old;
+  wq->pending = w;
+  interrupt_enable(saved);
+
+  return old;
+}
+
+static bmos_work_t *_work_take(bmos_workq_t *wq)
+{
+  unsigned int saved;
+  bmos_work_t *list;
+
+  saved = interrupt_disable();
+  list = wq->pending;
+  wq->pending = NULL;
+  interrupt_enable(saved);
+
+  return list;
+}
+#else
+static int _work_claim(bmos_work_t *w, unsigned int state)
+{
+  unsigned int idle = WORK_IDLE;
+
+  return __atomic_compare_exchange_n(&w->state, &idle, state, 0,
+                                     __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+
+static bmos_work_t *_work_push(bmos_workq_t *wq, bmos_work_t *w)
+{
+  bmos_work_t *old = __atomic_load_n(&wq->pending, __ATOMIC_RELAXED);
+
+  do
+    w->next = old;
+  while (!__atomic_compare_exchange_n(&wq->pending, &old, w, 1,
+                                      __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+
+  return old;
+}
+
+static bmos_work_t *_work_take(bmos_workq_t *wq)
+{
+  return __atomic_exchange_n(&wq->pending, NULL, __ATOMIC_ACQUIRE);
+}
+#endif
+
+void work_init(bmos_work_t *w, bmos_work_f_t *f, void *arg)
+{
+  w->next = NULL;
+  w->f = f;
+  w->arg = arg;
+  w->due = 0;
+  w->state = WORK_IDLE;
+}
+
+static int _work_submit(bmos_workq_t *wq, bmos_work_t *w)
+{
+  FAST_LOG('W', "work_submit '%s' %p\n", wq->name, w);
+
+  /* the worker only sleeps when the list is empty so wake it on the
+     first push */
+  if (!_work_push(wq, w))
+    sem_post(wq->sem);
+
+  return 1;
+}
+
+int work_submit(bmos_workq_t *wq, bmos_work_t *w)
+{
+  if (!_work_claim(w, WORK_QUEUED))
+    return 0;
+
+  return _work_submit(wq, w);
+}
+
+int work_submit_delayed(bmos_workq_t *wq, bmos_work_t *w, unsigned int tms)
+{
+  if (tms == 0)
+    return work_submit(wq, w);
+
+  if (!_work_claim(w, WORK_DELAYED))
+    return 0;
+
+  w->due = xtime_ms() + tms;
+
+  return _work_submit(wq, w);
+}
+
+/* worker only, sorted by due time. workq_info() reads the list with
+   interrupts disabled */
+static void _work_delay(bmos_workq_t *wq, bmos_work_t *w)
+{
+  bmos_work_t **p;
+
+  for (p = &wq->delayed; *p; p = &(*p)->next)
+    if (xtime_diff_ms(w->due, (*p)->due) < 0)
+      break;
+
+  w->next = *p;
+  *p = w;
+}
+
+static void _work_run(bmos_workq_t *wq, bmos_work_t *w)
+{
+  bmos_work_f_t *f = w->f;
+  void *arg = w->arg;
+
+  /* idle before the call so the function can submit itself again */
+#if __ARM_ARCH_6M__
+  w->state = WORK_IDLE;
+  asm volatile ("" : : : "memory");
+#else
+  __atomic_store_n(&w->state, WORK_IDLE, __ATOMIC_RELEASE);
+#endif
+
+  f(arg);
+
+  wq->count_run++;
+}
+
+static void workq_task(void *arg)
+{
+  bmos_workq_t *wq = arg;
+  bmos_work_t *list, *w, *next;
+  unsigned int count;
+  int tms;
+
+  for (;;) {
+    tms = -1;
+    if (wq->delayed) {
+      xtime_diff_ms_t diff = xtime_diff_ms(wq->delayed->due, xtime_ms());
+
+      tms = diff > 0 ? (int)diff : 0;
+    }
+
+    (void)sem_wait_ms(wq->sem, tms);
+
+    /* the list is lifo, reverse it to run in submit order */
+    for (list = NULL, w = _work_take(wq); w; w = next) {
+      next = w->next;
+      w->next = list;
+      list = w;
+    }
+
+    count = 0;
+    for (w = list; w; w = next) {
+      next = w->next;
+
+      if (w->state == WORK_DELAYED &&
+          xtime_diff_ms(w->due, xtime_ms()) > 0)
+        _work_delay(wq, w);
+      else {
+        _work_run(wq, w);
+        count++;
+      }
+    }
+
+    while ((w = wq->delayed) && xtime_diff_ms(w->due, xtime_ms()) <= 0) {
+      wq->delayed = w->next;
+      _work_run(wq, w);
+      count++;
+    }
+
+    if (count > wq->max_batch)
+      wq->max_batch = count;
+  }
+}
+
+bmos_workq_t *workq_create(const char *name, unsigned int prio,
+                           unsigned int stack_size)
+{
+  bmos_workq_t *wq = _bmos_calloc(sizeof(bmos_workq_t));
+
+  if (!wq)
+    return NULL;
+
+  if (stack_size == 0)
+    stack_size = CONFIG_WORKQ_STACK_SIZE;
+
+  wq->name = name;
+  wq->prio = prio;
+  wq->sem = sem_create(name, 0);
+  XASSERT(wq->sem);
+
+  bmos_reg(BMOS_REG_TYPE_WORKQ, &wq->reg);
+
+  wq->task = task_init(workq_task, wq, name, prio, NULL, stack_size);
+  XASSERT(wq->task);
+
+  return wq;
+}
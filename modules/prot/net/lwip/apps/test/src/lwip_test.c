@@ -10,6 +10,7 @@
 #include "bmos_queue.h"
 #include "bmos_syspool.h"
 #include "bmos_task.h"
+#include "common.h"
 #include "fast_log.h"
 #include "io.h"
 #include "mshell.h"
@@ -32,27 +33,29 @@ static telnet_esc_t telnet_esc;
 
 static void telnet_shell_put(void *arg)
 {
-  bmos_op_msg_t *m;
-  unsigned int len;
+  bmos_op_msg_t *m[4];
+  unsigned int i, count, len;
   unsigned char *data;
   err_t rerr;
 
   for (;;) {
-    m = op_msg_get(shell_tx);
-    if (!m)
+    count = op_msg_get_n(shell_tx, m, ARRSIZ(m));
+    if (count == 0)
       break;
 
-    len = m->len;
+    for (i = 0; i < count; i++) {
+      len = m[i]->len;
 
-    data = BMOS_OP_MSG_GET_DATA(m);
+      data = BMOS_OP_MSG_GET_DATA(m[i]);
 
-    if (telnet_pcb) {
-      rerr = tcp_write(telnet_pcb, data, len, TCP_WRITE_FLAG_COPY);
-      if (rerr != ERR_OK)
-        FAST_LOG('t', "tcp write error %d, len %d\n", rerr, len);
+      if (telnet_pcb) {
+        rerr = tcp_write(telnet_pcb, data, len, TCP_WRITE_FLAG_COPY);
+        if (rerr != ERR_OK)
+          FAST_LOG('t', "tcp write error %d, len %d\n", rerr, len);
+      }
     }
 
-    op_msg_return(m);
+    op_msg_return_n(m, count);
   }
 
   rerr = tcp_output(telnet_pcb);
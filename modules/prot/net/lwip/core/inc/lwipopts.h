@@ -85,6 +85,26 @@
 
 #define MEM_ALIGNMENT 4
 
+/* the h7 eth dma cannot reach dtcm where .bss lives, keep the lwip heap
+   and pools in .eth so tx frames can be sent from them in place */
+#if STM32_H7XX
+#define LWIP_DECLARE_MEMORY_ALIGNED(variable_name, size) \
+  u8_t variable_name[LWIP_MEM_ALIGN_BUFFER(size)] \
+  __attribute__((section(".eth"), aligned(MEM_ALIGNMENT)))
+#endif
+
 #define LWIP_TCP_KEEPALIVE 1
 
+/* the ethernet drivers hand rx dma buffers to lwip as custom pbufs */
+#define LWIP_SUPPORT_CUSTOM_PBUF 1
+
+/* checksums can be offloaded to the ethernet mac per netif */
+#define LWIP_CHECKSUM_CTRL_PER_NETIF 1
+
+/* word at a time checksums, see chksum.c */
+unsigned short bmos_chksum(const void *dataptr, int len);
+unsigned short bmos_chksum_copy(void *dst, const void *src, unsigned short len);
+#define LWIP_CHKSUM bmos_chksum
+#define LWIP_CHKSUM_COPY(dst, src, len) bmos_chksum_copy(dst, src, len)
+
 #endif /* LWIP_HDR_LWIPOPTS_H */
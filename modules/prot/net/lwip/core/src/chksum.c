@@ -0,0 +1,228 @@
+/* Copyright (c) 2026 Brian Thomas Murphy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* lwip checksum routines: 32 bit words summed with the carry folded back
+   in, on armv7-m eight words per loop with ldm and an adcs chain, on
+   other targets into a 64 bit accumulator. the result matches
+   lwip_standard_chksum for any alignment. */
+
+#include <string.h>
+
+#include "lwip/opt.h"
+#include "lwip/def.h"
+#include "lwip/inet_chksum.h"
+
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || \
+    defined(__ARM_ARCH_8M_MAIN__)
+#define CHKSUM_ASM 1
+typedef u32_t chksum_acc_t;
+
+static inline chksum_acc_t acc_add(chksum_acc_t sum, u32_t v)
+{
+  sum += v;
+  return sum + (sum < v);
+}
+
+static chksum_acc_t sum_words(const u32_t *pl, unsigned int n,
+                              chksum_acc_t sum)
+{
+  for (; n >= 8; n -= 8)
+    __asm__ volatile("ldmia %[p]!, {r3, r4, r5, r6}\n\t"
+                     "adds %[s], %[s], r3\n\t"
+                     "adcs %[s], %[s], r4\n\t"
+                     "adcs %[s], %[s], r5\n\t"
+                     "adcs %[s], %[s], r6\n\t"
+                     "ldmia %[p]!, {r3, r4, r5, r6}\n\t"
+                     "adcs %[s], %[s], r3\n\t"
+                     "adcs %[s], %[s], r4\n\t"
+                     "adcs %[s], %[s], r5\n\t"
+                     "adcs %[s], %[s], r6\n\t"
+                     "adc %[s], %[s], #0\n\t"
+                     : [s] "+r" (sum), [p] "+r" (pl)
+                     :
+                     : "r3", "r4", "r5", "r6", "cc", "memory");
+
+  for (; n; n--)
+    sum = acc_add(sum, *pl++);
+
+  return sum;
+}
+
+static chksum_acc_t copy_sum_words(u32_t *dl, const u32_t *pl,
+                                   unsigned int n, chksum_acc_t sum)
+{
+  for (; n >= 4; n -= 4)
+    __asm__ volatile("ldmia %[p]!, {r3, r4, r5, r6}\n\t"
+                     "stmia %[d]!, {r3, r4, r5, r6}\n\t"
+                     "adds %[s], %[s], r3\n\t"
+                     "adcs %[s], %[s], r4\n\t"
+                     "adcs %[s], %[s], r5\n\t"
+                     "adcs %[s], %[s], r6\n\t"
+                     "adc %[s], %[s], #0\n\t"
+                     : [s] "+r" (sum), [p] "+r" (pl), [d] "+r" (dl)
+                     :
+                     : "r3", "r4", "r5", "r6", "cc", "memory");
+
+  for (; n; n--) {
+    u32_t v = *pl++;
+
+    *dl++ = v;
+    sum = acc_add(sum, v);
+  }
+
+  return sum;
+}
+#else
+#define CHKSUM_ASM 0
+/* 2^32 words before the accumulator can overflow */
+typedef u64_t chksum_acc_t;
+
+static inline chksum_acc_t acc_add(chksum_acc_t sum, u32_t v)
+{
+  return sum + v;
+}
+
+static chksum_acc_t sum_words(const u32_t *pl, unsigned int n,
+                              chksum_acc_t sum)
+{
+  for (; n >= 4; n -= 4, pl += 4)
+    sum += (chksum_acc_t)pl[0] + pl[1] + (chksum_acc_t)pl[2] + pl[3];
+
+  for (; n; n--)
+    sum += *pl++;
+
+  return sum;
+}
+
+static chksum_acc_t copy_sum_words(u32_t *dl, const u32_t *pl,
+                                   unsigned int n, chksum_acc_t sum)
+{
+  for (; n >= 4; n -= 4, pl += 4, dl += 4) {
+    u32_t a = pl[0], b = pl[1], c = pl[2], d = pl[3];
+
+    dl[0] = a;
+    dl[1] = b;
+    dl[2] = c;
+    dl[3] = d;
+    sum += (chksum_acc_t)a + b + (chksum_acc_t)c + d;
+  }
+
+  for (; n; n--) {
+    u32_t v = *pl++;
+
+    *dl++ = v;
+    sum += v;
+  }
+
+  return sum;
+}
+#endif
+
+/* sum len bytes at pb, copying them to dst on the way when it is set.
+   dst must share the alignment of pb. */
+static u16_t chksum(u8_t *dst, const u8_t *pb, int len)
+{
+  chksum_acc_t sum = 0;
+  int odd = (mem_ptr_t)pb & 1;
+  unsigned int n;
+  u32_t s;
+  u16_t t = 0;
+
+  /* a leading odd byte goes in the high half, the result is swapped
+     back at the end */
+  if (odd && len > 0) {
+    ((u8_t *)&t)[1] = *pb;
+    if (dst)
+      *dst++ = *pb;
+    pb++;
+    len--;
+  }
+
+  if (((mem_ptr_t)pb & 2) && len > 1) {
+    u16_t v = *(const u16_t *)(const void *)pb;
+
+    if (dst) {
+      *(u16_t *)(void *)dst = v;
+      dst += 2;
+    }
+    sum = acc_add(sum, v);
+    pb += 2;
+    len -= 2;
+  }
+
+  n = len >> 2;
+  if (dst) {
+    sum = copy_sum_words((u32_t *)(void *)dst, (const u32_t *)(const void *)pb,
+                         n, sum);
+    dst += n * 4;
+  } else
+    sum = sum_words((const u32_t *)(const void *)pb, n, sum);
+  pb += n * 4;
+  len &= 3;
+
+  if (len > 1) {
+    u16_t v = *(const u16_t *)(const void *)pb;
+
+    if (dst) {
+      *(u16_t *)(void *)dst = v;
+      dst += 2;
+    }
+    sum = acc_add(sum, v);
+    pb += 2;
+    len -= 2;
+  }
+
+  if (len > 0) {
+    ((u8_t *)&t)[0] = *pb;
+    if (dst)
+      *dst = *pb;
+  }
+  sum = acc_add(sum, t);
+
+#if !CHKSUM_ASM
+  sum = (sum >> 32) + (sum & 0xffffffff);
+  sum = (sum >> 32) + (sum & 0xffffffff);
+#endif
+  s = (u32_t)sum;
+  s = FOLD_U32T(s);
+  s = FOLD_U32T(s);
+
+  if (odd)
+    s = SWAP_BYTES_IN_WORD(s);
+
+  return (u16_t)s;
+}
+
+u16_t bmos_chksum(const void *dataptr, int len)
+{
+  return chksum(NULL, dataptr, len);
+}
+
+u16_t bmos_chksum_copy(void *dst, const void *src, u16_t len)
+{
+  /* word copies need both sides on the same alignment */
+  if (((mem_ptr_t)dst ^ (mem_ptr_t)src) & 3) {
+    MEMCPY(dst, src, len);
+    return chksum(NULL, dst, len);
+  }
+
+  return chksum(dst, src, len);
+}
@@ -28,6 +28,18 @@
 
 void fast_log(const char *fmt, unsigned long v1, unsigned long v2);
 
+/* typed trace events, logged with the type in place of the format string.
+   tools/fast_log.py -c turns them into a chrome trace */
+#define FAST_TRACE_SWITCH 1 /* prev task name, next task name */
+#define FAST_TRACE_IRQ_B 2  /* irq number, irq name */
+#define FAST_TRACE_IRQ_E 3  /* irq number */
+#define FAST_TRACE_QUEUE 4  /* queue name, message count */
+#define FAST_TRACE_SEM 5    /* sem name, count */
+#define FAST_TRACE_MAX 16
+
+#define FAST_TRACE(type, v1, v2) \
+  FAST_LOG('@', (const char *)(type), v1, v2)
+
 #if CONFIG_FAST_LOG_ENABLE
 extern unsigned char fast_log_mask[];
 extern char fast_log_enabled;
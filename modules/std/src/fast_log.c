@@ -30,13 +30,32 @@
 #include "shell.h"
 #include "io.h"
 
+/* armv6-m has no cycle counter or ldrex/strex */
+#ifndef CONFIG_FAST_LOG_CYCLES
+#if __ARM_ARCH_6M__
+#define CONFIG_FAST_LOG_CYCLES 0
+#else
+#define CONFIG_FAST_LOG_CYCLES 1
+#endif
+#endif
+
+#if CONFIG_FAST_LOG_CYCLES
+#include "cortexm.h"
+#include "hal_board.h"
+#define FAST_LOG_NOW() cycle_cnt()
+#define FAST_LOG_PER_US (hal_cpu_clock / 1000000)
+#else
+#define FAST_LOG_NOW() hal_time_us()
+#define FAST_LOG_PER_US 1
+#endif
+
 #define FAST_LOG_ITEMS_LEN 128
 unsigned char fast_log_mask[FAST_LOG_ITEMS_LEN];
 char fast_log_enabled;
 int fast_log_stop_count = -1;
 
 typedef struct fast_log_entry_t {
-  unsigned int tus;
+  unsigned int ts;
   const char    *fmt;
   unsigned long v1;
   unsigned long v2;
@@ -50,30 +69,49 @@ typedef struct fast_log_entry_t {
 
 #define FAST_LOG_SIZE (1 << FAST_LOG_SHIFT)
 #define FAST_LOG_MASK (FAST_LOG_SIZE - 1)
+/* free running, masked on use so the dump knows how many are valid */
 static unsigned int fast_log_index = 0;
 static fle_t fast_log_entries[FAST_LOG_SIZE];
 
 void fast_log(const char *fmt, unsigned long v1, unsigned long v2)
 {
-  unsigned int idx, saved;
+  unsigned int idx;
   fle_t   *e;
 
+#if __ARM_ARCH_6M__
+  unsigned int saved;
+
   saved = interrupt_disable();
   if ((fast_log_stop_count > 0) && (--fast_log_stop_count == 0))
     fast_log_enable(0);
 
-  idx = fast_log_index;
-  fast_log_index = (fast_log_index + 1) & FAST_LOG_MASK;
+  idx = fast_log_index++;
   interrupt_enable(saved);
+#else
+  if ((fast_log_stop_count > 0) &&
+      (__atomic_sub_fetch(&fast_log_stop_count, 1, __ATOMIC_RELAXED) == 0))
+    fast_log_enable(0);
 
-  e = &fast_log_entries[idx];
+  /* ldrex/strex, an interrupting fast_log just takes the next slot */
+  idx = __atomic_fetch_add(&fast_log_index, 1, __ATOMIC_RELAXED);
+#endif
+
+  e = &fast_log_entries[idx & FAST_LOG_MASK];
 
-  e->tus = hal_time_us();
+  e->ts = FAST_LOG_NOW();
   e->fmt = fmt;
   e->v1 = v1;
   e->v2 = v2;
 }
 
+static const char *const fast_trace_fmt[FAST_TRACE_MAX] = {
+  [FAST_TRACE_SWITCH] = "switch '%s' -> '%s'\n",
+  [FAST_TRACE_IRQ_B] = "irq %d '%s'\n",
+  [FAST_TRACE_IRQ_E] = "irq %d done\n",
+  [FAST_TRACE_QUEUE] = "queue '%s' %d\n",
+  [FAST_TRACE_SEM] = "sem '%s' %d\n",
+};
+
 static void dputs(int debug, const char *str)
 {
   if (debug)
@@ -82,37 +120,74 @@ static void dputs(int debug, const char *str)
     xputs(str);
 }
 
+static unsigned int fast_log_first(unsigned int *ent)
+{
+  unsigned int lastidx = fast_log_index;
+
+  if (*ent > FAST_LOG_SIZE)
+    *ent = FAST_LOG_SIZE;
+
+  /* only entries that have been written */
+  if (*ent > lastidx)
+    *ent = lastidx;
+
+  return lastidx - *ent;
+}
+
 void fast_log_dump(unsigned int ent, int debug)
 {
-  unsigned int i;
+  unsigned int i, first, per_us = FAST_LOG_PER_US;
   char line[64];
   int count;
-  unsigned int last = 0, lastidx;
+  unsigned int last;
 
-  if (ent > FAST_LOG_SIZE)
-    ent = FAST_LOG_SIZE;
+  first = fast_log_first(&ent);
+  if (ent == 0)
+    return;
 
-  lastidx = fast_log_index;
+  last = fast_log_entries[first & FAST_LOG_MASK].ts;
 
   for (i = 0; i < ent; i++) {
-    unsigned int idx;
+    const char *fmt;
     fle_t *e;
 
-    idx = (i + lastidx - ent) & FAST_LOG_MASK;
-    e = &fast_log_entries[idx];
+    e = &fast_log_entries[(first + i) & FAST_LOG_MASK];
 
-    /* skip time zero (initial entry) */
-    if (e->tus == 0)
-      continue;
+    fmt = e->fmt;
+    if ((unsigned long)fmt < FAST_TRACE_MAX) {
+      fmt = fast_trace_fmt[(unsigned long)fmt];
+      if (!fmt)
+        fmt = "trace %08x %08x\n";
+    }
 
-    snprintf(line, sizeof(line), "%6u(%04u) ", e->tus, e->tus - last);
+    snprintf(line, sizeof(line), "%6u(%04u) ", e->ts / per_us,
+             (e->ts - last) / per_us);
     dputs(debug, line);
-    count = snprintf(line, sizeof(line), e->fmt, e->v1, e->v2);
+    count = snprintf(line, sizeof(line), fmt, e->v1, e->v2);
     dputs(debug, line);
-    if (line[count - 1] != '\n')
+    if (count > 0 && line[count - 1] != '\n')
       dputs(debug, "\n");
-    last = e->tus;
+    last = e->ts;
+  }
+}
+
+/* raw entries as hex for tools/fast_log.py, which looks the format strings
+   up in the elf. No formatting on target, so it is safe to use while
+   tracing is running */
+static void fast_log_dump_bin(unsigned int ent)
+{
+  unsigned int i, first;
+
+  first = fast_log_first(&ent);
+
+  xprintf("FLB %u %u\n", FAST_LOG_PER_US, ent);
+  for (i = 0; i < ent; i++) {
+    fle_t *e = &fast_log_entries[(first + i) & FAST_LOG_MASK];
+
+    xprintf("%08x%08x%08x%08x\n", e->ts, (unsigned int)e->fmt,
+            (unsigned int)e->v1, (unsigned int)e->v2);
   }
+  xprintf("FLE\n");
 }
 
 #define FAST_LOG_ENABLE 0xff
@@ -154,10 +229,38 @@ static void fast_log_show_items(void)
 
 void fast_log_init(const char *enable_items)
 {
+#if CONFIG_FAST_LOG_CYCLES
+  dwt_init();
+#endif
   fast_log_enable(strlen(enable_items) != 0);
   fast_log_enable_items(enable_items, 1);
 }
 
+/* per entry cost, the entries land in the log like any other */
+static void fast_log_measure(unsigned int count)
+{
+  unsigned int i, start, diff, saved;
+  char enabled = fast_log_enabled;
+  unsigned char mask = fast_log_mask['@'];
+
+  fast_log_enabled = 1;
+  fast_log_mask['@'] = FAST_LOG_ENABLE;
+
+  saved = interrupt_disable();
+  start = FAST_LOG_NOW();
+  for (i = 0; i < count; i++)
+    FAST_TRACE(FAST_TRACE_SEM, "measure", i);
+  diff = FAST_LOG_NOW() - start;
+  interrupt_enable(saved);
+
+  fast_log_enabled = enabled;
+  fast_log_mask['@'] = mask;
+
+  xprintf("%u entries %u us, %u ns per entry\n", count,
+          diff / FAST_LOG_PER_US,
+          (unsigned int)(diff * 1000ULL / FAST_LOG_PER_US / count));
+}
+
 int cmd_fast_log(int argc, char *argv[])
 {
   unsigned int count = 16;
@@ -173,6 +276,22 @@ int cmd_fast_log(int argc, char *argv[])
 
     fast_log_dump(count, 0);
     break;
+  case 'm':
+    count = 1000;
+    if (argc > 2)
+      count = atoi(argv[2]);
+    if (count == 0)
+      return -1;
+
+    fast_log_measure(count);
+    break;
+  case 'b':
+    count = FAST_LOG_SIZE;
+    if (argc > 2)
+      count = atoi(argv[2]);
+
+    fast_log_dump_bin(count);
+    break;
   case 'e':
     if (argc <= 2)
       return -1;
@@ -187,6 +306,9 @@ int cmd_fast_log(int argc, char *argv[])
     fast_log_show_items();
     break;
   case 't':
+#if CONFIG_FAST_LOG_CYCLES
+    dwt_init();
+#endif
     fast_log_enable(1);
     break;
   case 'p':
@@ -199,10 +321,12 @@ int cmd_fast_log(int argc, char *argv[])
 
 SHELL_CMD_H(fast_log, cmd_fast_log, "fast_log control\n\n"
             " i: show enabled items\n"
+            " m [count]: measure the cost of an entry\n"
             " p: stop\n"
             " t: start\n"
             " d <item>|*: disable items\n"
             " e <item>|*: enable items\n"
-            " s <count>: show entries"
+            " s <count>: show entries\n"
+            " b [count]: dump entries in hex for tools/fast_log.py"
             );
 #endif
@@ -0,0 +1,163 @@
+/* Copyright (c) 2026 Brian Thomas Murphy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* batched message calls: messages/s and interrupt locks per message of
+   op_msg_put_n/op_msg_get_n/op_msg_return_n against the single calls,
+   first from one task and then between a producer and a consumer task
+   where batching also saves task switches */
+
+#include <stdio.h>
+
+#include "bmos_host.h"
+#include "bmos_msg_queue.h"
+#include "bmos_op_msg.h"
+#include "bmos_task_priv.h"
+#include "common.h"
+
+#define POOL 64
+#define COUNT 400000
+#define BATCH_MAX 8
+
+static bmos_queue_t *pool, *loop_q, *q;
+static unsigned int batch;
+static int bad;
+
+#define FAIL(...) do { bad++; printf(__VA_ARGS__); } while (0)
+
+static void report(const char *what, unsigned int n, unsigned long long t,
+                   unsigned long irqs, unsigned long switches)
+{
+  printf("%-8s batch %u: %5.2f M msgs/s, %5.2f interrupt locks and %4.2f"
+         " task switches per msg\n", what, batch, n * 1e3 / t,
+         (double)(host_irq_count - irqs) / n,
+         (double)(host_switch_count - switches) / n);
+}
+
+/* pool -> loop_q -> pool round trips from one task, order is checked */
+static void loop_run(void)
+{
+  unsigned long irqs = host_irq_count, switches = host_switch_count;
+  bmos_op_msg_t *m[BATCH_MAX], *r[BATCH_MAX];
+  unsigned long long t = host_ns();
+  unsigned int i, j, n, seq = 0;
+
+  for (i = 0; i < COUNT; i += n) {
+    if (batch == 1) {
+      n = 1;
+      m[0] = op_msg_get(pool);
+      op_msg_put(loop_q, m[0], seq++, 0);
+      r[0] = op_msg_get(loop_q);
+      if (r[0]->op != m[0]->op)
+        FAIL("single: got %u, expected %u\n", r[0]->op, m[0]->op);
+      op_msg_return(r[0]);
+      continue;
+    }
+
+    n = op_msg_get_n(pool, m, batch);
+    if (n != batch)
+      FAIL("batch %u: only %u from the pool\n", batch, n);
+    for (j = 0; j < n; j++)
+      m[j]->op = seq++;
+    op_msg_put_n(loop_q, m, n);
+    if (op_msg_get_n(loop_q, r, n) != n)
+      FAIL("batch %u: short get\n", batch);
+    for (j = 0; j < n; j++)
+      if (r[j] != m[j])
+        FAIL("batch %u: out of order at %u\n", batch, j);
+    op_msg_return_n(r, n);
+  }
+
+  report("loop", COUNT, host_ns() - t, irqs, switches);
+}
+
+static bmos_task_static_t cons_tcb, prod_tcb;
+static unsigned long long cons_stack[64], prod_stack[64];
+static unsigned int received;
+
+/* above the producer, so it runs as soon as something is put */
+static void cons_task(void *arg)
+{
+  bmos_op_msg_t *m[BATCH_MAX];
+  unsigned int i, n;
+
+  for (;;) {
+    n = op_msg_wait_n_ms(q, m, BATCH_MAX, -1);
+    for (i = 0; i < n; i++)
+      if (m[i]->op != (unsigned short)received++)
+        FAIL("task: got %u\n", m[i]->op);
+    op_msg_return_n(m, n);
+  }
+}
+
+static void prod_task(void *arg)
+{
+  bmos_op_msg_t *m[BATCH_MAX];
+  unsigned long irqs, switches;
+  unsigned long long t;
+  unsigned int i, j, n, seq;
+
+  for (batch = 1; batch <= BATCH_MAX; batch <<= 1) {
+    loop_run();
+
+    irqs = host_irq_count;
+    switches = host_switch_count;
+    t = host_ns();
+    received = 0;
+    seq = 0;
+
+    for (i = 0; i < COUNT; i += n) {
+      if (batch == 1) {
+        n = 1;
+        op_msg_put(q, op_msg_get(pool), seq++, 0);
+        continue;
+      }
+      n = op_msg_get_n(pool, m, batch);
+      for (j = 0; j < n; j++) {
+        m[j]->op = seq++;
+        m[j]->len = 0;
+      }
+      op_msg_put_n(q, m, n);
+    }
+
+    report("tasks", COUNT, host_ns() - t, irqs, switches);
+    if (received != COUNT)
+      FAIL("task: received %u of %u\n", received, COUNT);
+  }
+
+  host_exit();
+}
+
+int main(int argc, char **argv)
+{
+  pool = op_msg_pool_create("pool", QUEUE_TYPE_TASK, POOL, 16);
+  loop_q = queue_create("loop", QUEUE_TYPE_TASK);
+  q = queue_create("q", QUEUE_TYPE_TASK);
+
+  task_init_static(&cons_tcb, cons_task, NULL, "cons", 2, cons_stack,
+                   sizeof(cons_stack));
+  task_init_static(&prod_tcb, prod_task, NULL, "prod", 1, prod_stack,
+                   sizeof(prod_stack));
+  task_start();
+
+  printf("%d bad\n", bad);
+
+  return bad != 0;
+}
@@ -0,0 +1,294 @@
+/* Copyright (c) 2026 Brian Thomas Murphy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* host side of the kernel: interrupt lock, pendsv and tick emulation and
+   the hal and io functions the kernel calls, see bmos_host.h */
+
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <ucontext.h>
+
+#include "bmos_host.h"
+#include "bmos_task_priv.h"
+#include "cortexm.h"
+#include "hal_int_cpu.h"
+#include "hal_time.h"
+#include "io.h"
+#include "xassert.h"
+
+#define CTX_MAGIC 0x686f7374
+#define CTX_STACK (256 * 1024)
+
+typedef struct {
+  unsigned int magic;
+  ucontext_t uc;
+} host_ctx_t;
+
+unsigned long host_irq_count;
+unsigned long host_switch_count;
+unsigned int host_tick_limit = 1000000;
+
+static pthread_mutex_t irq_lock = PTHREAD_MUTEX_INITIALIZER;
+static __thread unsigned int irq_off;
+static __thread int is_cpu;
+
+static int pendsv_pending, tick_pending;
+
+/* kernel entry points, called from start.S on target */
+void *_pendsv_handler(void *sp);
+void systick_handler(void);
+static host_ctx_t main_ctx;
+
+unsigned long long host_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int _is_ctx(void *sp)
+{
+  return sp && ((host_ctx_t *)sp)->magic == CTX_MAGIC;
+}
+
+/* first switch to a task, entered with the interrupt lock held like any
+   other return from a switch */
+static void _task_entry(unsigned int pc, unsigned int r0, unsigned int lr)
+{
+  irq_off = 0;
+  pthread_mutex_unlock(&irq_lock);
+
+  ((task_fun_t *)(uintptr_t)pc)((void *)(uintptr_t)r0);
+  ((void (*)(void))(uintptr_t)lr)();
+}
+
+static host_ctx_t *_ctx_from_frame(void *sp)
+{
+  stack_frame_t *sf = (stack_frame_t *)((sw_stack_frame_t *)sp + 1);
+  host_ctx_t *ctx = calloc(1, sizeof(host_ctx_t));
+  void *stack;
+
+  stack = mmap(NULL, CTX_STACK, PROT_READ | PROT_WRITE,
+               MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (!ctx || stack == MAP_FAILED)
+    xpanic("no memory for a task context");
+
+  getcontext(&ctx->uc);
+  ctx->uc.uc_stack.ss_sp = stack;
+  ctx->uc.uc_stack.ss_size = CTX_STACK;
+  ctx->uc.uc_link = NULL;
+  makecontext(&ctx->uc, (void (*)(void))_task_entry, 3, sf->pc, sf->r0,
+              sf->lr);
+  ctx->magic = CTX_MAGIC;
+
+  return ctx;
+}
+
+static void _pendsv(void)
+{
+  host_ctx_t *from, *to;
+  void *frame = NULL;
+
+  pendsv_pending = 0;
+  if (!CURRENT)
+    return;
+
+  /* the first switch leaves the caller of task_start() for the idle task
+     which is already CURRENT */
+  if (_is_ctx(CURRENT->sp)) {
+    if (NEXT == CURRENT)
+      return;
+    from = CURRENT->sp;
+  } else {
+    from = &main_ctx;
+    frame = CURRENT->sp;
+  }
+  main_ctx.magic = CTX_MAGIC;
+
+  to = _pendsv_handler(from);
+  if (to == &main_ctx)
+    to = frame;
+  if (!_is_ctx(to)) {
+    to = _ctx_from_frame(to);
+    CURRENT->sp = to;
+  }
+
+  host_switch_count++;
+  swapcontext(&from->uc, &to->uc);
+}
+
+/* called with the lock held, like the exception entry on target */
+static void _take_pending(void)
+{
+  if (!is_cpu)
+    return;
+
+  if (tick_pending) {
+    tick_pending = 0;
+    if (systick_count >= host_tick_limit)
+      xpanic("tick limit reached, deadlock?");
+    systick_handler();
+  }
+
+  if (pendsv_pending)
+    _pendsv();
+}
+
+unsigned int interrupt_disable(void)
+{
+  unsigned int saved = irq_off;
+
+  if (!irq_off) {
+    pthread_mutex_lock(&irq_lock);
+    irq_off = 1;
+    host_irq_count++;
+  }
+
+  return saved;
+}
+
+void interrupt_enable(unsigned int saved)
+{
+  if (saved || !irq_off)
+    return;
+
+  _take_pending();
+
+  irq_off = 0;
+  pthread_mutex_unlock(&irq_lock);
+}
+
+void interrupt_wfi(void)
+{
+  tick_pending = 1;
+}
+
+void host_irq_off(void)
+{
+  if (!irq_off)
+    interrupt_disable();
+}
+
+/* task_start() turns interrupts on from the thread that becomes the cpu */
+void host_irq_on(void)
+{
+  is_cpu = 1;
+  host_irq_off();
+  interrupt_enable(0);
+}
+
+void trigger_pendsv(void)
+{
+  pendsv_pending = 1;
+}
+
+void host_tick(void)
+{
+  unsigned int saved = interrupt_disable();
+
+  tick_pending = 1;
+  interrupt_enable(saved);
+}
+
+void host_exit(void)
+{
+  unsigned int saved = interrupt_disable();
+  host_ctx_t *from = CURRENT->sp;
+
+  (void)saved;
+  swapcontext(&from->uc, &main_ctx.uc);
+}
+
+/* the kernel times itself with this, keep it cheap */
+hal_time_us_t hal_time_us(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+  return ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+unsigned int cycle_cnt(void)
+{
+  return host_ns();
+}
+
+void dwt_init(void)
+{
+}
+
+void set_low_power(int en)
+{
+}
+
+unsigned int systick_suppress(unsigned int n)
+{
+  return 0;
+}
+
+void systick_hook(void)
+{
+}
+
+/* the host heap is libc's, _bmos_calloc() still catches use after boot */
+void sbrk_lock(void)
+{
+}
+
+int xvprintf(const char *fmt, va_list ap)
+{
+  return vprintf(fmt, ap);
+}
+
+int xprintf(const char *fmt, ...)
+{
+  va_list ap;
+  int rc;
+
+  va_start(ap, fmt);
+  rc = vprintf(fmt, ap);
+  va_end(ap);
+
+  return rc;
+}
+
+int debug_vprintf(const char *fmt, va_list ap)
+{
+  return vfprintf(stderr, fmt, ap);
+}
+
+void xpanic(const char *fmt, ...)
+{
+  va_list ap;
+
+  va_start(ap, fmt);
+  vfprintf(stderr, fmt, ap);
+  va_end(ap);
+  fprintf(stderr, "\n");
+
+  abort();
+}
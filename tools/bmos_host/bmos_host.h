@@ -0,0 +1,51 @@
+/* Copyright (c) 2026 Brian Thomas Murphy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* run the bmos kernel sources as a host program. Tasks are ucontexts on
+   the thread which calls task_start(), the cpu thread. Other host threads
+   act as interrupts: they share the interrupt lock but never switch tasks.
+   The idle task's wfi advances the tick by one ms.
+
+   Task functions and their arguments go through the 32 bit initial stack
+   frame, so tests are linked without pie and pass static arguments. */
+
+#ifndef BMOS_HOST_H
+#define BMOS_HOST_H
+
+/* interrupt_disable() calls which took the lock */
+extern unsigned long host_irq_count;
+
+/* task switches taken */
+extern unsigned long host_switch_count;
+
+/* give up after this many ticks of idling, the test has deadlocked */
+extern unsigned int host_tick_limit;
+
+/* back to the caller of task_start(), once all tests are done */
+void host_exit(void);
+
+/* take a tick now, as if the systick fired while the caller runs */
+void host_tick(void);
+
+/* monotonic host time */
+unsigned long long host_ns(void);
+
+#endif
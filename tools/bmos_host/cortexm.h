@@ -0,0 +1,65 @@
+/* Copyright (c) 2026 Brian Thomas Murphy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* host stand-in for cortexm.h, only what the kernel uses */
+
+#ifndef CORTEXM_H
+#define CORTEXM_H
+
+#include "common.h"
+
+typedef struct {
+  unsigned int r0;
+  unsigned int r1;
+  unsigned int r2;
+  unsigned int r3;
+  unsigned int r12;
+  unsigned int lr;
+  unsigned int pc;
+  unsigned int xpsr;
+} stack_frame_t;
+
+typedef struct {
+  unsigned int r4;
+  unsigned int r5;
+  unsigned int r6;
+  unsigned int r7;
+  unsigned int r8;
+  unsigned int r9;
+  unsigned int r10;
+  unsigned int r11;
+} sw_stack_frame_t;
+
+void set_low_power(int en);
+
+unsigned int systick_suppress(unsigned int n);
+
+void trigger_pendsv(void);
+
+static inline void clear_pendsv(void)
+{
+}
+
+unsigned int cycle_cnt(void);
+
+void dwt_init(void);
+
+#endif
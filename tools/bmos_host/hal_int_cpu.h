@@ -0,0 +1,50 @@
+/* Copyright (c) 2026 Brian Thomas Murphy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* host stand-in for the cortex-m interrupt primitives, see bmos_host.c.
+   interrupt_disable() takes one lock shared by all host threads, pending
+   ticks and task switches are taken when the cpu thread re-enables */
+
+#ifndef HAL_INT_CPU_H
+#define HAL_INT_CPU_H
+
+unsigned int interrupt_disable(void);
+void interrupt_enable(unsigned int saved);
+void interrupt_wfi(void);
+
+void host_irq_off(void);
+void host_irq_on(void);
+
+#define INTERRUPT_OFF() host_irq_off()
+#define INTERRUPT_ON() host_irq_on()
+
+#define __ISB() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define __DSB() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define __DMB() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+static inline void set_psp(void *psp)
+{
+  (void)psp;
+}
+
+#define INTERRUPT_ASSERT_CEILING() do { } while (0)
+
+#endif
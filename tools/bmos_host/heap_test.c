@@ -0,0 +1,136 @@
+/* Copyright (c) 2026 Brian Thomas Murphy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* heap used and time taken to create kernel objects with the _create calls
+   at boot against the _init_static variants. The static ones are made from
+   a task, after the scheduler has started, so with
+   CFLAGS=-DCONFIG_BMOS_NO_HEAP_AFTER_BOOT=1 any heap use by them panics */
+
+#include <malloc.h>
+#include <stdio.h>
+
+#include "bmos_event.h"
+#include "bmos_host.h"
+#include "bmos_mempool.h"
+#include "bmos_msg_queue.h"
+#include "bmos_mutex.h"
+#include "bmos_sem.h"
+#include "bmos_task.h"
+#include "common.h"
+
+#define N 16
+#define MSGS 8
+#define MSG_SIZE 32
+#define STACK 512
+
+static int bad;
+
+#define FAIL(...) do { bad++; printf(__VA_ARGS__); } while (0)
+
+static size_t heap_used(void)
+{
+  return mallinfo2().uordblks;
+}
+
+static void report(const char *what, size_t heap, unsigned long long t)
+{
+  printf("%-6s %u each of 7 kinds: %6zu heap bytes, %6.2f us\n", what, N,
+         heap, t / 1e3);
+}
+
+/* never runs, the test exits first */
+static void nop_task(void *arg)
+{
+  for (;;)
+    task_delay(1000);
+}
+
+static void dynamic_create(void)
+{
+  unsigned long long t = host_ns();
+  size_t heap = heap_used();
+  unsigned int i;
+
+  for (i = 0; i < N; i++) {
+    if (!sem_create("sem", 0) || !mutex_create("mutex") ||
+        !event_create("event") || !queue_create("queue", QUEUE_TYPE_TASK) ||
+        !msg_pool_create("pool", QUEUE_TYPE_TASK, MSGS, MSG_SIZE) ||
+        !mempool_create("mempool", MSGS, MSG_SIZE) ||
+        !task_init(nop_task, NULL, "task", 1, NULL, STACK))
+      FAIL("create %u failed\n", i);
+  }
+
+  report("create", heap_used() - heap, host_ns() - t);
+}
+
+static bmos_sem_static_t sems[N];
+static bmos_mutex_static_t mutexes[N];
+static bmos_event_static_t events[N];
+static bmos_queue_static_t queues[N], pools[N];
+static unsigned long long pool_mem[N][MSG_POOL_MEM_SIZE(MSGS, MSG_SIZE) / 8];
+static bmos_mempool_static_t mempools[N];
+static unsigned long long mempool_mem[N][MEMPOOL_MEM_SIZE(MSGS, MSG_SIZE) / 8];
+static bmos_task_static_t tcbs[N];
+static unsigned long long stacks[N][STACK / 8];
+
+static bmos_task_static_t boot_tcb;
+static unsigned long long boot_stack[STACK / 8];
+
+static void boot_task(void *arg)
+{
+  unsigned long long t = host_ns();
+  size_t heap = heap_used();
+  unsigned int i;
+
+  for (i = 0; i < N; i++) {
+    if (!sem_init_static(&sems[i], "sem", 0) ||
+        !mutex_init_static(&mutexes[i], "mutex") ||
+        !event_init_static(&events[i], "event") ||
+        !queue_init_static(&queues[i], "queue", QUEUE_TYPE_TASK) ||
+        !msg_pool_init_static(&pools[i], "pool", QUEUE_TYPE_TASK, MSGS,
+                              MSG_SIZE, pool_mem[i]) ||
+        !mempool_init_static(&mempools[i], "mempool", MSGS, MSG_SIZE,
+                             mempool_mem[i]) ||
+        !task_init_static(&tcbs[i], nop_task, NULL, "task", 1, stacks[i],
+                          STACK))
+      FAIL("init_static %u failed\n", i);
+  }
+
+  heap = heap_used() - heap;
+  report("static", heap, host_ns() - t);
+  if (heap)
+    FAIL("static variants used the heap\n");
+
+  host_exit();
+}
+
+int main(int argc, char **argv)
+{
+  dynamic_create();
+
+  task_init_static(&boot_tcb, boot_task, NULL, "boot", 2, boot_stack,
+                   sizeof(boot_stack));
+  task_start();
+
+  printf("%d bad\n", bad);
+
+  return bad != 0;
+}
@@ -0,0 +1,220 @@
+/* Copyright (c) 2026 Brian Thomas Murphy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* ring queue test: two host threads hammer a pair of rings, one carrying
+   numbered messages and one returning them, to check the lock free head
+   and tail updates. The same traffic over task queues gives the
+   throughput and interrupt lock comparison. Then a consumer task checks
+   the empty to non empty wakeup and the msg_wait_ms() timeout */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bmos_host.h"
+#include "bmos_msg_queue.h"
+#include "bmos_queue_priv.h"
+#include "bmos_task_priv.h"
+#include "common.h"
+
+#define N_MSGS 64
+#define RING_SIZE 16
+#define COUNT 2000000
+
+typedef struct {
+  bmos_msg_t msg;
+  unsigned int seq;
+} test_msg_t;
+
+static test_msg_t msgs[N_MSGS];
+static bmos_queue_t *to_cons, *to_prod;
+static unsigned int count, put_fails;
+static int bad;
+
+#define FAIL(...) do { bad++; printf(__VA_ARGS__); } while (0)
+
+/* the producer stands in for an interrupt handler */
+static void *producer(void *arg)
+{
+  unsigned int seq = 0;
+
+  while (seq < count) {
+    test_msg_t *m = (test_msg_t *)msg_get(to_prod);
+
+    if (!m) {
+      sched_yield();
+      continue;
+    }
+
+    m->seq = seq++;
+    while (msg_put(to_cons, &m->msg) < 0) {
+      put_fails++;
+      sched_yield();
+    }
+  }
+
+  return NULL;
+}
+
+static void consumer(void)
+{
+  unsigned int seq = 0;
+
+  while (seq < count) {
+    test_msg_t *m = (test_msg_t *)msg_get(to_cons);
+
+    if (!m) {
+      sched_yield();
+      continue;
+    }
+
+    if (m->seq != seq) {
+      FAIL("got message %u, expected %u\n", m->seq, seq);
+      seq = m->seq;
+    }
+    seq++;
+
+    if (msg_put(to_prod, &m->msg) < 0)
+      FAIL("return ring full\n");
+  }
+}
+
+static void run(const char *name, unsigned int n)
+{
+  unsigned long irqs = host_irq_count;
+  unsigned long long t;
+  pthread_t th;
+  unsigned int i;
+
+  count = n;
+  put_fails = 0;
+
+  for (i = 0; i < RING_SIZE; i++) {
+    msg_init(&msgs[i].msg, to_prod, sizeof(unsigned int));
+    msg_put(to_prod, &msgs[i].msg);
+  }
+
+  t = host_ns();
+  pthread_create(&th, NULL, producer, NULL);
+  consumer();
+  pthread_join(th, NULL);
+  t = host_ns() - t;
+
+  /* everything is back with the producer */
+  for (i = 0; msg_get(to_prod); i++)
+    ;
+  if (i != RING_SIZE || msg_get(to_cons))
+    FAIL("%s: %u messages left over\n", name, i);
+
+  printf("%-4s %u msgs: %6.1f M msgs/s, %.2f interrupt locks per msg,"
+         " %u full\n", name, n, n * 1e3 / t,
+         (double)(host_irq_count - irqs) / n, put_fails);
+}
+
+static bmos_task_static_t cons_tcb, prod_tcb;
+static unsigned long long cons_stack[64], prod_stack[64];
+static bmos_queue_t *wq;
+static unsigned int received, wakeups;
+
+#define BURSTS 50
+#define BURST 8
+
+/* lower priority than the producer, so a whole burst is queued before
+   it runs */
+static void cons_task(void *arg)
+{
+  queue_ring_data_t *r = &wq->type_data.ring;
+  xtime_ms_t start;
+  bmos_msg_t *m;
+
+  while (received < BURSTS * BURST) {
+    if (!(m = msg_get(wq))) {
+      wakeups++;
+      m = msg_wait(wq);
+    }
+    if (((test_msg_t *)m)->seq != received)
+      FAIL("wait: got message %u, expected %u\n",
+           ((test_msg_t *)m)->seq, received);
+    received++;
+  }
+
+  /* one post per burst, each used by a wakeup */
+  if (sem_count(r->sem) > 1)
+    FAIL("%u stale ring wakeups\n", sem_count(r->sem));
+
+  /* the producer's stale post half way must not extend the timeout */
+  start = xtime_ms();
+  if (msg_wait_ms(wq, 10))
+    FAIL("message from an empty ring\n");
+  if (xtime_ms() - start != 10)
+    FAIL("10 ms wait on an empty ring took %u ms\n", xtime_ms() - start);
+
+  host_exit();
+}
+
+static void prod_task(void *arg)
+{
+  unsigned int i, j, seq = 0;
+
+  for (i = 0; i < BURSTS; i++) {
+    for (j = 0; j < BURST; j++) {
+      msgs[j].seq = seq++;
+      msgs[j].msg.queue = NULL;
+      if (msg_put(wq, &msgs[j].msg) < 0)
+        FAIL("ring full\n");
+    }
+    task_delay(1);
+  }
+
+  task_delay(5);
+  sem_post(wq->type_data.ring.sem);
+}
+
+int main(int argc, char **argv)
+{
+  static bmos_msg_t *buf[2][RING_SIZE];
+  static bmos_queue_static_t qs[2];
+
+  to_cons = queue_ring_init_static(&qs[0], "to_cons", buf[0], RING_SIZE);
+  to_prod = queue_ring_init_static(&qs[1], "to_prod", buf[1], RING_SIZE);
+  run("ring", COUNT);
+
+  to_cons = queue_create("to_cons", QUEUE_TYPE_TASK);
+  to_prod = queue_create("to_prod", QUEUE_TYPE_TASK);
+  run("task", COUNT / 4);
+
+  wq = queue_ring_create("wq", BURST);
+  task_init_static(&cons_tcb, cons_task, NULL, "cons", 1, cons_stack,
+                   sizeof(cons_stack));
+  task_init_static(&prod_tcb, prod_task, NULL, "prod", 2, prod_stack,
+                   sizeof(prod_stack));
+  task_start();
+
+  /* the first burst is queued before the consumer first runs */
+  if (received != BURSTS * BURST || wakeups != BURSTS - 1)
+    FAIL("received %u in %u wakeups, expected %u in %u\n", received,
+         wakeups, BURSTS * BURST, BURSTS - 1);
+
+  printf("%d bad\n", bad);
+
+  return bad != 0;
+}
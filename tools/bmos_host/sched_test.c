@@ -0,0 +1,206 @@
+/* Copyright (c) 2026 Brian Thomas Murphy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* scheduler test: priority pick, round robin within a level and the
+   ready bitmap as tasks sleep, wake and exit, then the cost of picking
+   the next task against the number of sleeping tasks */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "bmos_host.h"
+#include "bmos_sem.h"
+#include "bmos_task_priv.h"
+#include "common.h"
+#include "hal_int_cpu.h"
+
+#define STACK 512
+
+/* as in task.c */
+#define TASK_STATE_RUN 1
+
+#define TASK(_n_) \
+  static bmos_task_static_t _n_##_tcb; \
+  static unsigned long long _n_##_stack[STACK / 8]
+
+TASK(hi);
+TASK(a);
+TASK(b);
+TASK(c);
+TASK(lo);
+
+static bmos_sem_static_t done_ss;
+static bmos_sem_t *done;
+
+static char trace[64];
+static unsigned int trace_len;
+static int bad;
+
+#define FAIL(...) do { bad++; printf(__VA_ARGS__); } while (0)
+
+static void log_c(char ch)
+{
+  if (trace_len < sizeof(trace) - 1)
+    trace[trace_len++] = ch;
+}
+
+static void expect_map(unsigned int map, const char *when)
+{
+  if (READY_MAP != map)
+    FAIL("%s: ready map %08x, expected %08x\n", when, READY_MAP, map);
+}
+
+static void hi_task(void *arg)
+{
+  unsigned int i;
+
+  log_c('h');
+  expect_map(BIT(7) | BIT(3) | BIT(1) | BIT(0), "start");
+
+  task_delay(50);
+
+  log_c('H');
+  expect_map(BIT(7) | BIT(0), "hi woken");
+
+  for (i = 0; i < 3; i++)
+    sem_post(done);
+
+  /* exit takes hi off the ready queue */
+}
+
+static void rr_task(void *arg)
+{
+  unsigned int i;
+
+  for (i = 0; i < 3; i++) {
+    log_c(*(const char *)arg);
+    if (READY[7])
+      FAIL("hi still on the ready queue while asleep\n");
+    host_tick();
+  }
+
+  sem_wait(done);
+
+  log_c(*(const char *)arg - 'a' + 'A');
+}
+
+static void bench(void);
+
+static void lo_task(void *arg)
+{
+  log_c('l');
+  expect_map(BIT(1) | BIT(0), "a, b, c and hi asleep");
+
+  task_delay(100);
+
+  log_c('L');
+  expect_map(BIT(1) | BIT(0), "lo woken");
+  if (READY[3] || READY[7])
+    FAIL("exited tasks left on the ready queue\n");
+
+  bench();
+
+  host_exit();
+}
+
+/* what schedule() did before the bitmap: walk every task for the
+   highest runnable one */
+static bmos_task_t *linear_pick(void)
+{
+  bmos_task_t *t, *best = NULL;
+
+  for (t = TASK_LIST; t; t = t->next)
+    if (t->state == TASK_STATE_RUN && (!best || t->prio > best->prio))
+      best = t;
+
+  return best;
+}
+
+#define N_SLEEPERS 64
+
+static bmos_task_static_t sleeper_tcb[N_SLEEPERS];
+static unsigned long long sleeper_stack[N_SLEEPERS][STACK / 8];
+static bmos_sem_static_t never_ss;
+static bmos_sem_t *never;
+
+static void sleeper_task(void *arg)
+{
+  sem_wait(never);
+}
+
+#define PICKS 1000000
+
+/* lo keeps running at priority 1 below all the sleepers */
+static void bench(void)
+{
+  static const unsigned int steps[] = { 0, 1, 4, 16, 64 };
+  unsigned int i, n = 0, k;
+
+  never = sem_init_static(&never_ss, "never", 0);
+
+  for (k = 0; k < ARRSIZ(steps); k++) {
+    unsigned long long t0, t1, t2;
+    unsigned int saved;
+
+    /* higher priority tasks which go straight to sleep */
+    for (; n < steps[k]; n++)
+      task_init_static(&sleeper_tcb[n], sleeper_task, NULL, "sleeper",
+                       2 + n % 29, sleeper_stack[n], STACK);
+    task_delay(1);
+
+    saved = interrupt_disable();
+    t0 = host_ns();
+    for (i = 0; i < PICKS; i++)
+      schedule();
+    t1 = host_ns();
+    for (i = 0; i < PICKS; i++)
+      if (!linear_pick())
+        break;
+    t2 = host_ns();
+    interrupt_enable(saved);
+
+    if (NEXT != CURRENT)
+      FAIL("schedule() picked '%s' over '%s'\n", NEXT->name, CURRENT->name);
+
+    printf("%2u sleeping tasks: schedule() %5.1f ns, linear walk %5.1f ns\n",
+           n, (double)(t1 - t0) / PICKS, (double)(t2 - t1) / PICKS);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  done = sem_init_static(&done_ss, "done", 0);
+
+  task_init_static(&hi_tcb, hi_task, NULL, "hi", 7, hi_stack, STACK);
+  task_init_static(&a_tcb, rr_task, "a", "a", 3, a_stack, STACK);
+  task_init_static(&b_tcb, rr_task, "b", "b", 3, b_stack, STACK);
+  task_init_static(&c_tcb, rr_task, "c", "c", 3, c_stack, STACK);
+  task_init_static(&lo_tcb, lo_task, NULL, "lo", 1, lo_stack, STACK);
+
+  task_start();
+
+  if (strcmp(trace, "habcabcabclHABCL"))
+    FAIL("run order %s, expected habcabcabclHABCL\n", trace);
+
+  printf("%d bad\n", bad);
+
+  return bad != 0;
+}
@@ -0,0 +1,164 @@
+/* Copyright (c) 2026 Brian Thomas Murphy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* order in which semaphore waiters are woken, fifo and with
+   sem_set_prio_order(), including after a waiter in the middle of the list
+   has timed out, and the latency of waking a higher priority waiter */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "bmos_host.h"
+#include "bmos_sem.h"
+#include "bmos_task.h"
+#include "common.h"
+
+#define STACK 512
+#define LAT_COUNT 100000
+
+typedef struct {
+  char name;
+  unsigned int prio;
+  int tms;
+  bmos_sem_static_t start_ss;
+  bmos_sem_t *start;
+  bmos_task_static_t tcb;
+  unsigned long long stack[STACK / 8];
+} waiter_t;
+
+/* in order of arrival on the semaphore, x times out once all are queued
+   and h arrives after that */
+static waiter_t waiters[] = {
+  { 'a', 2 }, { 'b', 5 }, { 'x', 4, 3 }, { 'c', 3 }, { 'd', 5 },
+  { 'e', 7 }, { 'f', 3 }, { 'g', 2 }, { 'h', 2 },
+};
+
+#define N_WAITERS ARRSIZ(waiters)
+#define TIMEOUT_IDX 2
+
+static bmos_sem_static_t wait_ss, lat_ss;
+static bmos_sem_t *wait_sem, *lat_sem;
+
+static char trace[32];
+static unsigned int trace_len;
+static int bad;
+
+#define FAIL(...) do { bad++; printf(__VA_ARGS__); } while (0)
+
+static void waiter_task(void *arg)
+{
+  waiter_t *w = arg;
+
+  for (;;) {
+    sem_wait(w->start);
+    if (w->tms) {
+      if (sem_wait_ms(wait_sem, w->tms) == 0)
+        FAIL("%c didn't time out\n", w->name);
+    } else {
+      sem_wait(wait_sem);
+      trace[trace_len++] = w->name;
+    }
+  }
+}
+
+static void order_run(int by_prio, const char *expect)
+{
+  unsigned int i;
+
+  sem_set_prio_order(wait_sem, by_prio);
+  trace_len = 0;
+  memset(trace, 0, sizeof(trace));
+
+  /* one at a time, each blocks on wait_sem before the next is started */
+  for (i = 0; i < N_WAITERS; i++) {
+    if (i == N_WAITERS - 1) /* all but h are queued, let x time out */
+      task_delay(waiters[TIMEOUT_IDX].tms + 2);
+    sem_post(waiters[i].start);
+    task_delay(1);
+  }
+
+  /* the woken waiter runs before the next post */
+  for (i = 0; i < N_WAITERS - 1; i++) {
+    sem_post(wait_sem);
+    task_delay(1);
+  }
+
+  printf("%-4s woken %s\n", by_prio ? "prio" : "fifo", trace);
+  if (strcmp(trace, expect))
+    FAIL("expected %s\n", expect);
+  if (sem_count(wait_sem))
+    FAIL("count %u left\n", sem_count(wait_sem));
+}
+
+static bmos_task_static_t ctl_tcb, lat_tcb;
+static unsigned long long ctl_stack[STACK / 8], lat_stack[STACK / 8];
+static unsigned long long lat_post, lat_sum;
+
+/* above the controller, sem_post switches straight to it */
+static void lat_task(void *arg)
+{
+  for (;;) {
+    sem_wait(lat_sem);
+    lat_sum += host_ns() - lat_post;
+  }
+}
+
+static void ctl_task(void *arg)
+{
+  unsigned int i;
+
+  order_run(0, "abcdefgh");
+  order_run(1, "ebdcfagh");
+
+  for (i = 0; i < LAT_COUNT; i++) {
+    lat_post = host_ns();
+    sem_post(lat_sem);
+  }
+  printf("wakeup of a higher priority waiter: %.1f ns\n",
+         (double)lat_sum / LAT_COUNT);
+
+  host_exit();
+}
+
+int main(int argc, char **argv)
+{
+  unsigned int i;
+  waiter_t *w;
+
+  wait_sem = sem_init_static(&wait_ss, "wait", 0);
+  lat_sem = sem_init_static(&lat_ss, "lat", 0);
+
+  for (i = 0; i < N_WAITERS; i++) {
+    w = &waiters[i];
+    w->start = sem_init_static(&w->start_ss, "start", 0);
+    task_init_static(&w->tcb, waiter_task, w, "waiter", w->prio, w->stack,
+                     sizeof(w->stack));
+  }
+  task_init_static(&ctl_tcb, ctl_task, NULL, "ctl", 10, ctl_stack,
+                   sizeof(ctl_stack));
+  task_init_static(&lat_tcb, lat_task, NULL, "lat", 11, lat_stack,
+                   sizeof(lat_stack));
+  task_start();
+
+  printf("%d bad\n", bad);
+
+  return bad != 0;
+}
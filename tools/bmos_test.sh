@@ -0,0 +1,33 @@
+#!/bin/sh
+# build the bmos kernel for the host with each test in tools/bmos_host and
+# run them, see bmos_host/bmos_host.h
+#
+# usage: tools/bmos_test.sh [test ...]
+#
+# tests are named by their file without _test.c, all are run by default.
+# Extra compiler flags, e.g. kernel options, can be given in CFLAGS.
+
+set -e
+
+top=$(cd "$(dirname "$0")/.." && pwd)
+host=$top/tools/bmos_host
+out=${TMPDIR:-/tmp}/bmos_test.$$
+inc=$(find "$top/modules" -type d -name inc | grep -v tusb | sed 's/^/-I/')
+
+trap 'rm -f $out' EXIT
+
+tests=$*
+if [ -z "$tests" ]; then
+  tests=$(cd $host && ls *_test.c | sed 's/_test\.c$//')
+fi
+
+for t in $tests; do
+  echo "== $t"
+  # task entry points travel in 32 bit stack frames, so no pie
+  ${CC:-cc} -O2 -g -Wall -Wno-pointer-to-int-cast -Wno-int-to-pointer-cast \
+    -Wno-unused-function -no-pie -fno-pie -pthread \
+    -DBMOS -DARCH_STM32 -DCONFIG_FAST_LOG_ENABLE=0 $CFLAGS \
+    -I$host $inc -I$top/modules/os/bmos/src -o $out \
+    $host/${t}_test.c $host/bmos_host.c $top/modules/os/bmos/src/*.c
+  $out
+done
@@ -0,0 +1,169 @@
+/* Copyright (c) 2026 Brian Thomas Murphy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* host check of the lwip checksum routines in chksum.c: the portable path
+   is compared bit for bit against lwip_standard_chksum algorithm 2 and
+   both are timed. build and run with tools/chksum_test.sh */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+unsigned short bmos_chksum(const void *dataptr, int len);
+unsigned short bmos_chksum_copy(void *dst, const void *src,
+                                unsigned short len);
+
+#define FOLD_U32T(u) ((uint32_t)(((u) >> 16) + ((u) & 0x0000ffffUL)))
+#define SWAP_BYTES_IN_WORD(w) ((((w) & 0xff) << 8) | (((w) & 0xff00) >> 8))
+
+/* lwip_standard_chksum, LWIP_CHKSUM_ALGORITHM 2 */
+static uint16_t ref_chksum(const void *dataptr, int len)
+{
+  const uint8_t *pb = (const uint8_t *)dataptr;
+  const uint16_t *ps;
+  uint16_t t = 0;
+  uint32_t sum = 0;
+  int odd = ((uintptr_t)pb & 1);
+
+  if (odd && len > 0) {
+    ((uint8_t *)&t)[1] = *pb++;
+    len--;
+  }
+
+  ps = (const uint16_t *)(const void *)pb;
+  while (len > 1) {
+    sum += *ps++;
+    len -= 2;
+  }
+
+  if (len > 0)
+    ((uint8_t *)&t)[0] = *(const uint8_t *)ps;
+
+  sum += t;
+
+  sum = FOLD_U32T(sum);
+  sum = FOLD_U32T(sum);
+
+  if (odd)
+    sum = SWAP_BYTES_IN_WORD(sum);
+
+  return (uint16_t)sum;
+}
+
+#define BUF_LEN (65536 + 16)
+
+static uint8_t src[BUF_LEN] __attribute__((aligned(8)));
+static uint8_t dst[BUF_LEN] __attribute__((aligned(8)));
+
+static int bad;
+
+static void check(int off, int len)
+{
+  unsigned short r, c, cc;
+
+  r = ref_chksum(src + off, len);
+  c = bmos_chksum(src + off, len);
+  if (c != r) {
+    if (bad++ < 10)
+      printf("sum off %d len %d: %04x != %04x\n", off, len, c, r);
+    return;
+  }
+
+  memset(dst, 0x5a, BUF_LEN);
+  cc = bmos_chksum_copy(dst + off, src + off, len);
+  if (cc != r || memcmp(dst + off, src + off, len) ||
+      dst[off + len] != 0x5a || (off && dst[off - 1] != 0x5a))
+    if (bad++ < 10)
+      printf("copy off %d len %d: %04x != %04x\n", off, len, cc, r);
+}
+
+static double now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void bench(int len)
+{
+  volatile unsigned short sink;
+  int i, n = (64 << 20) / len;
+  double t0, t1, t2;
+
+  t0 = now();
+  for (i = 0; i < n; i++)
+    sink = ref_chksum(src + (i & 1), len);
+  t1 = now();
+  for (i = 0; i < n; i++)
+    sink = bmos_chksum(src + (i & 1), len);
+  t2 = now();
+  (void)sink;
+
+  printf("len %5d: ref %7.1f MB/s, bmos %7.1f MB/s, %.1fx\n", len,
+         n * (double)len / (t1 - t0) / 1e6,
+         n * (double)len / (t2 - t1) / 1e6, (t1 - t0) / (t2 - t1));
+}
+
+int main(int argc, char **argv)
+{
+  int i, off, len, runs = argc > 1 ? atoi(argv[1]) : 200000;
+
+  srand(1);
+
+  /* all ones and all zeros hit the carry folding at both extremes */
+  memset(src, 0xff, BUF_LEN);
+  for (off = 0; off < 8; off++)
+    for (len = 0; len < 2048; len++)
+      check(off, len);
+  check(0, 65535);
+  check(1, 65535);
+
+  memset(src, 0, BUF_LEN);
+  for (off = 0; off < 8; off++)
+    for (len = 0; len < 64; len++)
+      check(off, len);
+
+  for (i = 0; i < BUF_LEN; i++)
+    src[i] = rand();
+
+  for (off = 0; off < 8; off++)
+    for (len = 0; len < 2048; len++)
+      check(off, len);
+
+  for (i = 0; i < runs; i++) {
+    if (i % 1000 == 0)
+      src[rand() % BUF_LEN] = rand();
+    off = rand() & 7;
+    len = i & 1 ? rand() % 1600 : rand() % 65536;
+    check(off, len);
+  }
+
+  printf("%d runs, %d bad\n", runs, bad);
+
+  bench(64);
+  bench(1460);
+  bench(65535);
+
+  return bad != 0;
+}
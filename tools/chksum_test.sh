@@ -0,0 +1,18 @@
+#!/bin/sh
+# build the portable path of the lwip checksum routines for the host and
+# compare it with lwip_standard_chksum, see chksum_test.c
+#
+# usage: tools/chksum_test.sh [runs]
+
+set -e
+
+top=$(cd "$(dirname "$0")/.." && pwd)
+out=${TMPDIR:-/tmp}/chksum_test.$$
+inc=$(find "$top/modules" -type d -name inc | sed 's/^/-I/')
+
+trap 'rm -f $out' EXIT
+
+${CC:-cc} -O2 -Wall -DBMOS -DARCH_STM32 -DCONFIG_LWIP -D__S_FILE__='"chksum"' \
+  $inc -o $out "$top/tools/chksum_test.c" \
+  "$top/modules/prot/net/lwip/core/src/chksum.c"
+$out "$@"
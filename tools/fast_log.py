@@ -0,0 +1,260 @@
+#!/usr/bin/python3
+# Copyright (c) 2026 Brian Thomas Murphy
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to
+# deal in the Software without restriction, including without limitation the
+# rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+# sell copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+# FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+# IN THE SOFTWARE.
+
+# decode a "fast_log b" dump using the format strings in the elf
+#
+# usage: fast_log.py [-c] <elf> [dump]
+#
+# the dump is read from stdin if no file is given. Lines before "FLB" and
+# after "FLE" are ignored so a whole console capture can be fed in.
+#
+# -c writes chrome trace json instead of text, load it in chrome://tracing
+# or ui.perfetto.dev. Tasks and irqs get their own tracks, queue and sem
+# counts are counters and other fast_log lines are instant events.
+
+import getopt
+import json
+import re
+import struct
+import sys
+
+SHF_ALLOC = 0x2
+SHT_NOBITS = 8
+
+# must match FAST_TRACE_* in fast_log.h
+TRACE_SWITCH = 1
+TRACE_IRQ_B = 2
+TRACE_IRQ_E = 3
+TRACE_QUEUE = 4
+TRACE_SEM = 5
+TRACE_MAX = 16
+
+TRACE_FMT = {
+    TRACE_SWITCH: "switch '%s' -> '%s'\n",
+    TRACE_IRQ_B: "irq %d '%s'\n",
+    TRACE_IRQ_E: "irq %d done\n",
+    TRACE_QUEUE: "queue '%s' %d\n",
+    TRACE_SEM: "sem '%s' %d\n",
+}
+
+PID_TASK = 0
+PID_IRQ = 1
+
+FMT_RE = re.compile(r'%([-+ #0]*)(\d*)(\.\d+)?(hh|h|ll|l|z)?([diouxXcsp%])')
+
+
+class Elf:
+    def __init__(self, name):
+        with open(name, 'rb') as f:
+            self.data = f.read()
+
+        if self.data[:4] != b'\x7fELF' or self.data[4] != 1:
+            raise ValueError('%s: not a 32 bit elf' % name)
+
+        shoff, = struct.unpack_from('<I', self.data, 0x20)
+        shentsize, shnum = struct.unpack_from('<HH', self.data, 0x2e)
+
+        self.sections = []
+        for i in range(shnum):
+            (_, stype, flags, addr, offset,
+             size) = struct.unpack_from('<IIIIII', self.data,
+                                        shoff + i * shentsize)
+            if (flags & SHF_ALLOC) and stype != SHT_NOBITS and addr:
+                self.sections.append((addr, offset, size))
+
+    def string(self, addr):
+        for (saddr, offset, size) in self.sections:
+            if saddr <= addr < saddr + size:
+                start = offset + addr - saddr
+                end = self.data.find(b'\0', start, offset + size)
+                if end < 0:
+                    end = offset + size
+                return self.data[start:end].decode('latin-1')
+        return None
+
+
+def cformat(elf, fmt, args):
+    args = list(args)
+
+    def conv(m):
+        flags, width, prec, _, spec = m.groups()
+        if spec == '%':
+            return '%'
+        if not args:
+            return m.group(0)
+        v = args.pop(0)
+        prec = prec or ''
+        if spec == 's':
+            s = elf.string(v)
+            return ('%' + flags + width + prec + 's') % (
+                s if s is not None else '<%08x>' % v)
+        if spec == 'p':
+            return '0x%08x' % v
+        if spec == 'c':
+            return chr(v & 0xff)
+        if spec in 'di' and v & 0x80000000:
+            v -= 1 << 32
+        if spec == 'u':
+            spec = 'd'
+        return ('%' + flags + width + prec + spec) % v
+
+    return FMT_RE.sub(conv, fmt)
+
+
+def entries(lines):
+    """yield (time us, delta us, fmt, v1, v2) for each dumped entry. The
+    time counts from the first entry of each dump and doesn't wrap with the
+    32 bit cycle counter"""
+    per_us = 1
+    last = None
+    t = 0
+    active = False
+
+    for line in lines:
+        line = line.strip()
+        if line.startswith('FLB'):
+            per_us = int(line.split()[1]) or 1
+            last = None
+            t = 0
+            active = True
+            continue
+        if line.startswith('FLE'):
+            active = False
+            continue
+        if not active or len(line) != 32:
+            continue
+
+        ts, fmt, v1, v2 = struct.unpack('>IIII', bytes.fromhex(line))
+        if last is None:
+            last = ts
+        delta = (ts - last) & 0xffffffff
+        last = ts
+        t += delta
+
+        yield (t / per_us, delta / per_us, fmt, v1, v2)
+
+
+def text(elf, fmt, v1, v2):
+    if fmt < TRACE_MAX:
+        s = TRACE_FMT.get(fmt, 'trace %08x %08x\n')
+    else:
+        s = elf.string(fmt)
+    if s is None:
+        return '<fmt %08x> %08x %08x' % (fmt, v1, v2)
+    return cformat(elf, s, (v1, v2)).rstrip('\n')
+
+
+def decode(elf, lines):
+    for (t, delta, fmt, v1, v2) in entries(lines):
+        sys.stdout.write('%10.3f(%8.3f) %s\n' % (t, delta,
+                                                   text(elf, fmt, v1, v2)))
+
+
+def name(elf, addr):
+    s = elf.string(addr)
+    if s is None:
+        s = '%08x' % addr
+    return s
+
+
+def chrome(elf, lines):
+    events = []
+    tids = {}
+    running = None
+    irqs = set()
+
+    def task_tid(n):
+        if n not in tids:
+            tids[n] = len(tids) + 1
+            events.append({'ph': 'M', 'name': 'thread_name', 'pid': PID_TASK,
+                           'tid': tids[n], 'args': {'name': n}})
+        return tids[n]
+
+    events.append({'ph': 'M', 'name': 'process_name', 'pid': PID_TASK,
+                   'args': {'name': 'tasks'}})
+    events.append({'ph': 'M', 'name': 'process_name', 'pid': PID_IRQ,
+                   'args': {'name': 'irqs'}})
+
+    for (t, _, fmt, v1, v2) in entries(lines):
+        if fmt == TRACE_SWITCH:
+            prev, nxt = name(elf, v1), name(elf, v2)
+            if running == prev:
+                events.append({'ph': 'E', 'pid': PID_TASK,
+                               'tid': task_tid(prev), 'ts': t})
+            events.append({'ph': 'B', 'pid': PID_TASK, 'tid': task_tid(nxt),
+                           'ts': t, 'name': nxt})
+            running = nxt
+        elif fmt == TRACE_IRQ_B:
+            n = name(elf, v2)
+            if v1 not in irqs:
+                irqs.add(v1)
+                events.append({'ph': 'M', 'name': 'thread_name',
+                               'pid': PID_IRQ, 'tid': v1,
+                               'args': {'name': '%d %s' % (v1, n)}})
+            events.append({'ph': 'B', 'pid': PID_IRQ, 'tid': v1, 'ts': t,
+                           'name': n})
+        elif fmt == TRACE_IRQ_E:
+            if v1 in irqs:
+                events.append({'ph': 'E', 'pid': PID_IRQ, 'tid': v1,
+                               'ts': t})
+        elif fmt in (TRACE_QUEUE, TRACE_SEM):
+            kind = 'queue' if fmt == TRACE_QUEUE else 'sem'
+            events.append({'ph': 'C', 'pid': PID_TASK, 'ts': t,
+                           'name': '%s %s' % (kind, name(elf, v1)),
+                           'args': {'count': v2}})
+        else:
+            events.append({'ph': 'i', 's': 'g', 'pid': PID_TASK, 'tid': 0,
+                           'ts': t, 'name': text(elf, fmt, v1, v2)})
+
+    json.dump({'traceEvents': events, 'displayTimeUnit': 'ns'}, sys.stdout)
+    sys.stdout.write('\n')
+
+
+def usage():
+    sys.stderr.write('usage: %s [-c] <elf> [dump]\n' % sys.argv[0])
+    sys.exit(1)
+
+
+def main():
+    try:
+        opts, args = getopt.getopt(sys.argv[1:], 'c')
+    except getopt.GetoptError:
+        usage()
+
+    if len(args) < 1:
+        usage()
+
+    out = decode
+    for o, _ in opts:
+        if o == '-c':
+            out = chrome
+
+    elf = Elf(args[0])
+
+    if len(args) > 1:
+        with open(args[1]) as f:
+            out(elf, f)
+    else:
+        out(elf, sys.stdin)
+
+
+if __name__ == '__main__':
+    main()
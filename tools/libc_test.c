@@ -0,0 +1,323 @@
+/* Copyright (c) 2026 Brian Thomas Murphy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* host check of the libc_min word loops: memcpy, memmove, memset, memcmp
+   and strlen are compared against the host libc over alignment and length
+   sweeps, memmove also for overlapping buffers, then both are timed.
+   build and run with tools/libc_test.sh */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+/* libc_min is built with a 32 bit size_t */
+void *lm_memcpy(void *dest, const void *src, unsigned int n);
+void *lm_memmove(void *dest, const void *src, unsigned int n);
+void *lm_memset(void *p, int v, unsigned int s);
+int lm_memcmp(const void *s1, const void *s2, unsigned int n);
+unsigned int lm_strlen(const char *s);
+
+#define BUF_LEN (65536 + 64)
+#define GUARD 0x5a
+
+static unsigned char src[BUF_LEN] __attribute__((aligned(16)));
+static unsigned char dst[BUF_LEN] __attribute__((aligned(16)));
+static unsigned char ref[BUF_LEN] __attribute__((aligned(16)));
+
+static int bad;
+
+#define FAIL(...) do { if (bad++ < 10) printf(__VA_ARGS__); } while (0)
+
+static int sign(int v)
+{
+  return (v > 0) - (v < 0);
+}
+
+static void check_copy(int doff, int soff, int len)
+{
+  memset(dst, GUARD, len + 64);
+  if (lm_memcpy(dst + doff, src + soff, len) != dst + doff ||
+      memcmp(dst + doff, src + soff, len) ||
+      dst[doff + len] != GUARD || (doff && dst[doff - 1] != GUARD))
+    FAIL("memcpy doff %d soff %d len %d\n", doff, soff, len);
+}
+
+static void check_set(int off, int v, int len)
+{
+  memset(dst, GUARD, len + 64);
+  memset(ref, GUARD, len + 64);
+  memset(ref + off, v, len);
+  if (lm_memset(dst + off, v, len) != dst + off ||
+      memcmp(dst, ref, len + 64))
+    FAIL("memset off %d v %x len %d\n", off, v, len);
+}
+
+static void check_cmp(int off1, int off2, int len)
+{
+  int pos;
+
+  memcpy(dst + off2, src + off1, len);
+  if (lm_memcmp(src + off1, dst + off2, len) != 0)
+    FAIL("memcmp off %d %d len %d equal\n", off1, off2, len);
+
+  /* a difference in every byte position, both ways */
+  for (pos = 0; pos < len; pos++) {
+    unsigned char c = dst[off2 + pos];
+
+    dst[off2 + pos] = c ^ 0x81;
+    if (sign(lm_memcmp(src + off1, dst + off2, len)) !=
+        sign(memcmp(src + off1, dst + off2, len)) ||
+        sign(lm_memcmp(dst + off2, src + off1, len)) !=
+        sign(memcmp(dst + off2, src + off1, len)))
+      FAIL("memcmp off %d %d len %d pos %d\n", off1, off2, len, pos);
+    dst[off2 + pos] = c;
+  }
+}
+
+static void check_move(int off, int shift, int len)
+{
+  int s = 32 + off, d = 32 + off + shift;
+
+  memcpy(dst, src, len + 64);
+  memcpy(ref, src, len + 64);
+  memmove(ref + d, ref + s, len);
+  if (lm_memmove(dst + d, dst + s, len) != dst + d ||
+      memcmp(dst, ref, len + 64))
+    FAIL("memmove off %d shift %d len %d\n", off, shift, len);
+}
+
+/* strings ending at the last byte before an unmapped page catch reads
+   past the terminator */
+static void check_strlen(unsigned char *page_end)
+{
+  int off, len;
+
+  for (off = 0; off < 8; off++)
+    for (len = 0; len < 300; len++) {
+      char *s = (char *)dst + off;
+
+      memset(dst, 'a', len + 64);
+      s[len] = 0;
+      if (lm_strlen(s) != (unsigned int)len)
+        FAIL("strlen off %d len %d\n", off, len);
+    }
+
+  for (len = 0; len < 64; len++) {
+    char *s = (char *)page_end - 1 - len;
+
+    memset(s, 'b', len);
+    s[len] = 0;
+    if (lm_strlen(s) != (unsigned int)len)
+      FAIL("strlen page end len %d\n", len);
+  }
+}
+
+static unsigned char *guard_page(void)
+{
+  long pg = sysconf(_SC_PAGESIZE);
+  unsigned char *p;
+
+  p = mmap(NULL, 2 * pg, PROT_READ | PROT_WRITE,
+           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (p == MAP_FAILED || mprotect(p + pg, pg, PROT_NONE)) {
+    perror("mmap");
+    exit(1);
+  }
+
+  return p + pg;
+}
+
+static double now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* the byte loops libc_min had before, kept scalar so they stay a
+   baseline */
+#define BYTES __attribute__((noinline, \
+  optimize("no-tree-vectorize", "no-tree-loop-distribute-patterns")))
+
+static BYTES void byte_copy(unsigned char *d, const unsigned char *s, int n)
+{
+  while (n--)
+    *d++ = *s++;
+}
+
+static BYTES void byte_move(unsigned char *d, const unsigned char *s, int n)
+{
+  d += n;
+  s += n;
+  while (n--)
+    *--d = *--s;
+}
+
+static BYTES void byte_set(unsigned char *d, int v, int n)
+{
+  while (n--)
+    *d++ = v;
+}
+
+static BYTES int byte_cmp(const unsigned char *s1, const unsigned char *s2,
+                          int n)
+{
+  for (; n--; s1++, s2++)
+    if (*s1 != *s2)
+      return *s1 < *s2 ? -1 : 1;
+
+  return 0;
+}
+
+static volatile int sink;
+
+/* the dest of memmove overlaps above src to take the backward path */
+enum { F_LIBC, F_BYTES, F_MIN };
+
+static void b_memcpy(int f, int len, int off)
+{
+  if (f == F_LIBC)
+    memcpy(dst, src + off, len);
+  else if (f == F_BYTES)
+    byte_copy(dst, src + off, len);
+  else
+    lm_memcpy(dst, src + off, len);
+}
+
+static void b_memmove(int f, int len, int off)
+{
+  if (f == F_LIBC)
+    memmove(dst + 8 + off, dst, len);
+  else if (f == F_BYTES)
+    byte_move(dst + 8 + off, dst, len);
+  else
+    lm_memmove(dst + 8 + off, dst, len);
+}
+
+static void b_memset(int f, int len, int off)
+{
+  if (f == F_LIBC)
+    memset(dst + off, off, len);
+  else if (f == F_BYTES)
+    byte_set(dst + off, off, len);
+  else
+    lm_memset(dst + off, off, len);
+}
+
+static void b_memcmp(int f, int len, int off)
+{
+  if (f == F_LIBC)
+    sink = memcmp(src, ref + off, len);
+  else if (f == F_BYTES)
+    sink = byte_cmp(src, ref + off, len);
+  else
+    sink = lm_memcmp(src, ref + off, len);
+}
+
+typedef void bench_f_t(int f, int len, int off);
+
+static double rate(bench_f_t *bf, int f, int len, int off)
+{
+  int i, n = (128 << 20) / (len + 16);
+  double t;
+
+  t = now();
+  for (i = 0; i < n; i++)
+    bf(f, len, off);
+  t = now() - t;
+
+  return n * (double)len / t / 1e6;
+}
+
+static void bench(const char *name, bench_f_t *bf)
+{
+  static const int lens[] = { 16, 64, 256, 1500, 65536 };
+  unsigned int i;
+  int off;
+
+  for (off = 0; off < 2; off++) {
+    /* memcmp runs over equal buffers */
+    memcpy(ref + off, src, BUF_LEN - 8);
+
+    for (i = 0; i < sizeof(lens) / sizeof(lens[0]); i++) {
+      double r = rate(bf, F_LIBC, lens[i], off);
+      double b = rate(bf, F_BYTES, lens[i], off);
+      double l = rate(bf, F_MIN, lens[i], off);
+
+      printf("%-7s %s %5d: libc %8.1f bytes %7.1f libc_min %7.1f MB/s,"
+             " %.1fx bytes\n", name, off ? "unaligned" : "aligned  ",
+             lens[i], r, b, l, l / b);
+    }
+  }
+}
+
+int main(int argc, char **argv)
+{
+  static const int vals[] = { 0, 0xa5, 0xff, 0x1ff, -1 };
+  unsigned char *page_end = guard_page();
+  int i, doff, soff, len;
+
+  srand(1);
+  for (i = 0; i < BUF_LEN; i++)
+    src[i] = rand();
+
+  for (doff = 0; doff < 8; doff++)
+    for (soff = 0; soff < 8; soff++)
+      for (len = 0; len < 300; len++) {
+        check_copy(doff, soff, len);
+        check_cmp(doff, soff, len & 63);
+      }
+  for (soff = 0; soff < 8; soff++) {
+    check_copy(0, soff, 65536);
+    check_copy(3, soff, 4099);
+  }
+
+  for (doff = 0; doff < 8; doff++)
+    for (i = 0; i < (int)(sizeof(vals) / sizeof(vals[0])); i++)
+      for (len = 0; len < 300; len++)
+        check_set(doff, vals[i], len);
+  check_set(1, 0x3c, 65536);
+
+  /* dest below, on and above src, overlapping and not */
+  for (doff = 0; doff < 8; doff++)
+    for (soff = -20; soff <= 20; soff++)
+      for (len = 0; len < 200; len++)
+        check_move(doff, soff, len);
+  check_move(1, 7, 65536 - 64);
+  check_move(2, -5, 65536 - 64);
+
+  check_strlen(page_end);
+
+  printf("%d bad\n", bad);
+
+  if (argc > 1 && !strcmp(argv[1], "-b")) {
+    bench("memcpy", b_memcpy);
+    bench("memmove", b_memmove);
+    bench("memset", b_memset);
+    bench("memcmp", b_memcmp);
+  }
+
+  return bad != 0;
+}
@@ -0,0 +1,34 @@
+#!/bin/sh
+# build the libc_min mem and string functions for the host and compare
+# them with the host libc, see libc_test.c
+#
+# usage: tools/libc_test.sh [-b]
+#
+# -b also prints the throughput against the host libc and the byte loops
+# libc_min used before. The unaligned load path is enabled as on armv7-m,
+# the ldm/stm pairing is up to the target compiler.
+
+set -e
+
+top=$(cd "$(dirname "$0")/.." && pwd)
+tmp=${TMPDIR:-/tmp}/libc_test.$$
+inc=$(find "$top/modules" -type d -name inc | sed 's/^/-I/')
+src=$top/modules/lib/libc_min/src
+
+trap 'rm -f $tmp $tmp.*.o' EXIT
+
+# libc_min defines its own 32 bit size_t and most of libc, build it as on
+# target and keep only the functions under test, renamed with lm_
+for f in libc xlib; do
+  ${CC:-cc} -O2 -fno-builtin -w -U__SIZE_TYPE__ '-D__SIZE_TYPE__=unsigned int' \
+    -D__ARM_FEATURE_UNALIGNED=1 $inc -c -o $tmp.$f.o $src/$f.c
+done
+ld -r -o $tmp.min.o $tmp.libc.o $tmp.xlib.o
+keep=""
+for s in memcpy memmove memset memcmp strlen; do
+  keep="$keep --redefine-sym $s=lm_$s -G lm_$s"
+done
+objcopy $keep $tmp.min.o $tmp.lm.o
+
+${CC:-cc} -O2 -Wall -o $tmp "$top/tools/libc_test.c" $tmp.lm.o
+$tmp "$@"
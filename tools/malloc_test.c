@@ -0,0 +1,237 @@
+/* Copyright (c) 2026 Brian Thomas Murphy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* host stress test of the libc_min allocator: random malloc, free and
+   realloc with a shadow pattern check of every live block, free list
+   invariant checks, and peak heap and fragmentation output. build and
+   run with tools/malloc_test.sh */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* build the allocator under other names on top of a fixed arena */
+#define malloc lm_malloc
+#define free lm_free
+#define realloc lm_realloc
+#define sbrk lm_sbrk
+#include "../modules/lib/libc_min/src/malloc.c"
+#undef malloc
+#undef free
+#undef realloc
+#undef sbrk
+
+/* headers are twice the target size here, so twice the 64 KB */
+#define ARENA_MAX (1024 * 1024)
+
+static unsigned char arena[ARENA_MAX] __attribute__((aligned(16)));
+static unsigned int arena_size = 128 * 1024;
+static unsigned int brk_top;
+
+void *lm_sbrk(intptr_t count)
+{
+  void *p = arena + brk_top;
+
+  if (brk_top + count > arena_size)
+    return (void *)-1;
+  brk_top += count;
+
+  return p;
+}
+
+#define SLOTS 512
+
+typedef struct {
+  unsigned char *p;
+  unsigned int size;
+  unsigned char seed;
+} slot_t;
+
+static slot_t slots[SLOTS];
+static unsigned int live, live_peak;
+static int bad;
+
+#define FAIL(...) do { if (bad++ < 10) printf(__VA_ARGS__); } while (0)
+
+static void fill(slot_t *s, unsigned int from)
+{
+  unsigned int i;
+
+  for (i = from; i < s->size; i++)
+    s->p[i] = s->seed + i * 7;
+}
+
+static void verify(slot_t *s, unsigned int n, const char *what)
+{
+  unsigned int i;
+
+  for (i = 0; i < n; i++)
+    if (s->p[i] != (unsigned char)(s->seed + i * 7)) {
+      FAIL("%s: block %p size %u corrupt at %u\n", what, s->p, s->size, i);
+      return;
+    }
+}
+
+/* address ordered, coalesced and inside the arena, no block both on the
+   free list and in a bin */
+static void check_lists(void)
+{
+  malloc_hdr_t *p, *b;
+  unsigned int i;
+
+  for (p = malloc_data.free_list; p; p = p->next) {
+    if ((unsigned char *)p < arena ||
+        (unsigned char *)(p + p->size) > arena + brk_top)
+      FAIL("free block %p outside the heap\n", p);
+    if (p->next && p + p->size >= p->next)
+      FAIL("free list %p %p not ordered or not coalesced\n", p, p->next);
+  }
+
+  for (i = 1; i <= BIN_UNITS; i++)
+    for (b = malloc_data.bins[i]; b; b = b->next) {
+      if (b->size != i)
+        FAIL("bin %u holds size %u\n", i, b->size);
+      for (p = malloc_data.free_list; p; p = p->next)
+        if (b >= p && b < p + p->size)
+          FAIL("bin block %p inside free block %p\n", b, p);
+    }
+}
+
+static void frag_show(const char *when)
+{
+  malloc_hdr_t *p;
+  unsigned int i, tot = 0, largest = 0, n = 0, binned = 0;
+
+  for (p = malloc_data.free_list; p; p = p->next) {
+    tot += p->size;
+    if (p->size > largest)
+      largest = p->size;
+    n++;
+  }
+  for (i = 1; i <= BIN_UNITS; i++)
+    for (p = malloc_data.bins[i]; p; p = p->next)
+      binned += i;
+
+  printf("%-6s heap %6u live %6u free %6u in %4u blocks, largest %6u,"
+         " binned %5u, frag %u%%\n", when, brk_top, live,
+         (unsigned int)(tot * CHUNK_SIZE), n,
+         (unsigned int)(largest * CHUNK_SIZE),
+         (unsigned int)(binned * CHUNK_SIZE),
+         tot ? 100 - largest * 100 / tot : 0);
+}
+
+/* mostly small blocks as lwip and the kernel allocate, some frame sized
+   and the odd large one */
+static unsigned int rand_size(void)
+{
+  unsigned int r = rand() % 100;
+
+  if (r < 70)
+    return 1 + rand() % 128;
+  if (r < 95)
+    return 129 + rand() % 1536;
+  return 1665 + rand() % 6000;
+}
+
+int main(int argc, char **argv)
+{
+  unsigned int ops = argc > 1 ? strtoul(argv[1], NULL, 0) : 1000000;
+  unsigned int fails = 0, reallocs = 0, i;
+
+  if (argc > 2)
+    arena_size = strtoul(argv[2], NULL, 0);
+  if (arena_size > ARENA_MAX)
+    arena_size = ARENA_MAX;
+
+  srand(1);
+
+  for (i = 0; i < ops; i++) {
+    slot_t *s = &slots[rand() % SLOTS];
+    unsigned int r = rand() % 10;
+
+    if (!s->p) {
+      unsigned int size = rand_size();
+
+      s->p = lm_malloc(size);
+      if (!s->p) {
+        fails++;
+        continue;
+      }
+      s->size = size;
+      s->seed = rand();
+      fill(s, 0);
+      live += size;
+    } else if (r < 2) {
+      unsigned int size = rand_size(), keep;
+      unsigned char *p;
+
+      verify(s, s->size, "realloc");
+      p = lm_realloc(s->p, size);
+      if (!p) {
+        fails++;
+        continue;
+      }
+      reallocs++;
+      s->p = p;
+      keep = size < s->size ? size : s->size;
+      verify(s, keep, "realloc copy");
+      live += size - s->size;
+      s->size = size;
+      fill(s, keep);
+    } else {
+      verify(s, s->size, "free");
+      lm_free(s->p);
+      live -= s->size;
+      s->p = NULL;
+    }
+
+    if (live > live_peak)
+      live_peak = live;
+    if (i % 1024 == 0)
+      check_lists();
+  }
+
+  printf("%u ops, %u reallocs, %u failed, peak live %u, peak heap %u"
+         " (%u%% overhead)\n", ops, reallocs, fails, live_peak, brk_top,
+         live_peak ? (brk_top - live_peak) * 100 / live_peak : 0);
+  frag_show("end");
+
+  for (i = 0; i < SLOTS; i++)
+    if (slots[i].p) {
+      verify(&slots[i], slots[i].size, "final");
+      lm_free(slots[i].p);
+      live -= slots[i].size;
+    }
+  check_lists();
+  frag_show("freed");
+
+  /* with everything freed the bins drain back into one block */
+  _drain_bins();
+  frag_show("drain");
+  if (!malloc_data.free_list || malloc_data.free_list->next ||
+      malloc_data.free_list->size * CHUNK_SIZE != brk_top)
+    FAIL("heap did not coalesce back to one block\n");
+
+  printf("%d bad\n", bad);
+
+  return bad != 0;
+}
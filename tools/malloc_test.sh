@@ -0,0 +1,17 @@
+#!/bin/sh
+# build the libc_min allocator for the host and stress it, see
+# malloc_test.c
+#
+# usage: tools/malloc_test.sh [ops [heap bytes]]
+
+set -e
+
+top=$(cd "$(dirname "$0")/.." && pwd)
+out=${TMPDIR:-/tmp}/malloc_test.$$
+inc=$(find "$top/modules" -type d -name inc | sed 's/^/-I/')
+
+trap 'rm -f $out' EXIT
+
+${CC:-cc} -O2 -Wall -Wno-unused-function $inc -o $out \
+  "$top/tools/malloc_test.c"
+$out "$@"